@@ -0,0 +1,31 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size, size_t num_instances) : ring_size_(ring_size) {
+  BUSTUB_ASSERT(ring_size > 0 && num_instances > 0, "A buffer ring needs at least one frame.");
+  // A sequential scan spreads its pages evenly over the instances, so every instance gets its share of the ring.
+  const size_t per_instance = std::max<size_t>(1, (ring_size + num_instances - 1) / num_instances);
+  rings_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    rings_.emplace_back(per_instance);
+  }
+}
+
+}  // namespace bustub
@@ -11,177 +11,435 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
-#include <iterator>
-#include <ostream>
-#include "include/common/logger.h"
 
-namespace bustub {
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 
-template <typename T, typename InputIterator>
-void PrintContainer(std::ostream &ostr, InputIterator begin, InputIterator end, const std::string &delimiter) {
-  std::copy(begin, end, std::ostream_iterator<T>(ostr, delimiter.c_str()));
-}
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
 
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
+    : BufferPoolManager(1, pool_size, disk_manager, log_manager) {}
+
+BufferPoolManager::BufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                     LogManager *log_manager, ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
+  BUSTUB_ASSERT(num_instances > 0 && num_instances <= pool_size, "Every instance needs at least one frame.");
+  for (size_t i = 0; i < num_instances; ++i) {
+    const size_t instance_size = GetInstanceSize(pool_size, num_instances, i);
+    instances_.emplace_back(
+        std::make_unique<BufferPoolManagerInstance>(instance_size, disk_manager, log_manager, replacer_type));
+  }
+}
 
-  pages_ = std::make_unique<std::vector<Page>>(pool_size);
-  replacer_ = std::make_unique<LRUReplacer>(pool_size);
+BufferPoolManager::~BufferPoolManager() {
+  StopMetricsReporter();
+  StopPoolDumper();
+  StopBackgroundWriter();
+}
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+Page *BufferPoolManager::FetchPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
   }
+  return GetInstance(page_id)->FetchPage(page_id);
 }
 
-BufferPoolManager::~BufferPoolManager() {}
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  const size_t index = GetInstanceIndex(page_id);
+  return instances_[index]->FetchPage(page_id, strategy == nullptr ? nullptr : strategy->GetRing(index));
+}
 
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> gurad(latch_);
-  if (auto it = page_table_.find(page_id); it != page_table_.end()) {
-    auto const &frame_id = it->second;
-    auto &page = pages_->at(frame_id);
-    page.pin_count_++;
-    replacer_->Pin(frame_id);
-    // LOG_DEBUG("Fetch Page id:%d, frame id:%d", page_id, frame_id);
-    return &page;
+Page *BufferPoolManager::FetchPageOptimistic(page_id_t page_id, uint64_t *version) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
   }
+  return GetInstance(page_id)->FetchPageOptimistic(page_id, version);
+}
 
-  if (CheckAllPinned()) {
-    // LOG_WARN("Fail to search a free frame, page id:%d", page_id);
+Page *BufferPoolManager::FetchResidentPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
     return nullptr;
   }
-  // LOG_DEBUG("Free list size:%zu, Replacer size: %zu, page id:%d", free_list_.size(), replacer_->Size(), page_id);
-  frame_id_t frame_id;
-  ObtainFreeFrame(&frame_id);
-  auto &page = pages_->at(frame_id);
-  ResetPage(frame_id, page_id);
-  // LOG_DEBUG("Fetch page id: %d", page.GetPageId());
-  disk_manager_->ReadPage(page.GetPageId(), page.GetData());
-  replacer_->Pin(frame_id);
-  page_table_.emplace(page_id, frame_id);
+  return GetInstance(page_id)->FetchResidentPage(page_id);
+}
 
-  // LOG_DEBUG("Fetch Page id:%d, frame id:%d", page_id, frame_id);
-  return &page;
+void BufferPoolManager::PrefetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  PrefetchRange(page_id, 1, strategy);
+}
+
+void BufferPoolManager::PrefetchRange(page_id_t first_page_id, size_t count, BufferAccessStrategy *strategy) {
+  if (first_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  const page_id_t num_pages = disk_manager_->GetNumPages();
+  std::vector<page_id_t> page_ids;
+  std::vector<char *> pages;
+  std::vector<DiskManager::IOCallback> callbacks;
+  for (size_t i = 0; i < count && first_page_id + static_cast<page_id_t>(i) < num_pages; ++i) {
+    const page_id_t page_id = first_page_id + static_cast<page_id_t>(i);
+    // A deallocated page holds garbage, and a frame holding it would outlive the page id being handed out again.
+    if (!disk_manager_->GetFreeSpaceMap().IsAllocated(page_id)) {
+      continue;
+    }
+    const size_t index = GetInstanceIndex(page_id);
+    BufferPoolManagerInstance *instance = instances_[index].get();
+    Page *page = instance->BeginPrefetch(page_id, strategy == nullptr ? nullptr : strategy->GetRing(index));
+    if (page == nullptr) {
+      continue;
+    }
+    page_ids.push_back(page_id);
+    pages.push_back(page->GetData());
+    callbacks.emplace_back([instance, page_id](bool ok) { instance->CompletePrefetch(page_id, ok); });
+  }
+  // The frames of the whole range are reserved first, so that the reads go out together.
+  disk_manager_->ReadPagesAsync(page_ids, pages, std::move(callbacks));
 }
 
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::mutex> gurad(latch_);
-  if (auto it = page_table_.find(page_id); it == page_table_.end()) {
-    // LOG_WARN("Unpin page id:%d", page_id);
+  if (page_id == INVALID_PAGE_ID) {
     return false;
   }
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
 
-  const frame_id_t frame_id = page_table_[page_id];
-  Page &page = pages_->at(frame_id);
-  page.is_dirty_ |= is_dirty;
-  if (page.GetPinCount() <= 0) {
-    LOG_ERROR("page id: %d, pin count: %d", page_id, page.GetPinCount());
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
     return false;
   }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
 
-  page.pin_count_ -= 1;
-  if (page.GetPinCount() <= 0) {
-    replacer_->Unpin(frame_id);  // Insert frame to replacer
-    // page_table_.erase(page_id);
-    // LOG_DEBUG("Unpin page id:%d, frame id: %d", page_id, frame_id);
+Page *BufferPoolManager::NewPage(page_id_t *page_id, ExtentAllocator *allocator) {
+  // Don't burn a page id when there is obviously no room for it.
+  if (CheckAllPinned()) {
+    counters_.Add(BufferPoolCounter::NO_FREE_FRAME);
+    return nullptr;
   }
 
-  return true;
+  const page_id_t new_page_id = allocator == nullptr ? disk_manager_->AllocatePage() : allocator->AllocatePage();
+  if (new_page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = GetInstance(new_page_id)->NewPage(new_page_id);
+  if (page == nullptr) {
+    // The instance owning this id is full even though some other instance is not; give the id back.
+    if (allocator == nullptr) {
+      disk_manager_->DeallocatePage(new_page_id);
+    } else {
+      allocator->DeallocatePage(new_page_id);
+    }
+    return nullptr;
+  }
+  *page_id = new_page_id;
+  return page;
 }
 
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
-  if (page_table_.find(page_id) == page_table_.end() || page_id == INVALID_PAGE_ID) {
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  if (!GetInstance(page_id)->DeletePage(page_id)) {
     return false;
   }
+  disk_manager_->DeallocatePage(page_id);
+  return true;
+}
 
-  auto const frame_id = page_table_[page_id];
-  Page &page = pages_->at(frame_id);
-  if (page.IsDirty()) {
-    disk_manager_->WritePage(page_id, page.GetData());
-    page.is_dirty_ = false;
+void BufferPoolManager::FlushAllPages() {
+  // Instances own every n-th page, so only the dirty pages of all of them together form runs worth coalescing.
+  std::vector<Page *> pages;
+  for (auto &instance : instances_) {
+    std::vector<Page *> instance_pages = instance->PinDirtyPages();
+    pages.insert(pages.end(), instance_pages.begin(), instance_pages.end());
+  }
+  std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) { return a->GetPageId() < b->GetPageId(); });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<const char *> run;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    run.push_back(pages[i]->GetData());
+    if (i + 1 == pages.size() || pages[i + 1]->GetPageId() != pages[i]->GetPageId() + 1) {
+      disk_manager_->WritePages(pages[i]->GetPageId() - static_cast<page_id_t>(run.size() - 1), run);
+      run.clear();
+    }
+  }
+  // Pages evicted before the flush may still be on their way to disk; the sync has to cover them too.
+  disk_manager_->DrainAsyncIO();
+  disk_manager_->Sync();
+  counters_.Add(BufferPoolCounter::FLUSHES, pages.size());
+  counters_.AddTimeSince(BufferPoolCounter::FLUSH_TIME_US, start);
+
+  for (Page *page : pages) {
+    UnpinPage(page->GetPageId(), false);
   }
-  LOG_DEBUG("FlushPage page id:%d frame id: %d", page_id, frame_id);
-  return true;
 }
 
-Page *BufferPoolManager::NewPage(page_id_t *page_id) {
-  if (CheckAllPinned()) {
-    return nullptr;
+size_t BufferPoolManager::CleanColdFrames(size_t clean_percent, size_t max_pages) {
+  // The write budget is shared evenly, so one instance full of dirty pages cannot starve the others.
+  const size_t max_pages_per_instance = (max_pages + instances_.size() - 1) / instances_.size();
+  size_t num_writes = 0;
+  for (auto &instance : instances_) {
+    const size_t num_clean_frames = (instance->GetPoolSize() * clean_percent + 99) / 100;
+    num_writes += instance->CleanColdFrames(num_clean_frames, max_pages_per_instance);
   }
+  return num_writes;
+}
 
-  *page_id = disk_manager_->AllocatePage();
-  frame_id_t frame_id;
-  if (ObtainFreeFrame(&frame_id)) {
-    // LOG_INFO("new page id:%d frame id:%d", *page_id, frame_id);
-    auto &page = pages_->at(frame_id);
-    ResetPage(frame_id, *page_id);
-    page_table_[*page_id] = frame_id;
-    replacer_->Pin(frame_id);
-    return &page;
+void BufferPoolManager::StartBackgroundWriter(size_t clean_percent, size_t max_pages) {
+  if (enable_background_writer_.exchange(true)) {
+    return;
   }
-  // LOG_WARN("Can't create a new page, without free list");
-  return nullptr;
+  background_writer_ =
+      std::make_unique<std::thread>(&BufferPoolManager::RunBackgroundWriter, this, clean_percent, max_pages);
 }
 
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  if (auto it = page_table_.find(page_id); it == page_table_.end()) {
-    return true;
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::lock_guard<std::mutex> guard(background_writer_latch_);
+    if (!enable_background_writer_.exchange(false)) {
+      return;
+    }
   }
+  background_writer_cv_.notify_all();
+  background_writer_->join();
+  background_writer_.reset();
+}
 
-  auto const frame_id = page_table_[page_id];
-  auto &page = pages_->at(frame_id);
-  if (page.GetPinCount() > 0) {
-    return false;
+void BufferPoolManager::RunBackgroundWriter(size_t clean_percent, size_t max_pages) {
+  std::unique_lock<std::mutex> lock(background_writer_latch_);
+  while (enable_background_writer_) {
+    lock.unlock();
+    CleanColdFrames(clean_percent, max_pages);
+    lock.lock();
+    background_writer_cv_.wait_for(lock, bgwriter_interval, [this] { return !enable_background_writer_; });
   }
-  page_table_.erase(page_id);
-  if (page.IsDirty()) {
-    disk_manager_->WritePage(page_id, page.GetData());
+}
+
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) const {
+  // Take turns between the instances, so that the hottest pages of every instance come first in the dump.
+  std::vector<std::vector<page_id_t>> resident(instances_.size());
+  size_t num_pages = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    resident[i] = instances_[i]->GetResidentPages();
+    num_pages += resident[i].size();
+  }
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(num_pages);
+  for (size_t rank = 0; page_ids.size() < num_pages; ++rank) {
+    for (const auto &instance_pages : resident) {
+      if (rank < instance_pages.size()) {
+        page_ids.push_back(instance_pages[rank]);
+      }
+    }
   }
-  page_table_.erase(page_id);
-  disk_manager_->DeallocatePage(page_id);
 
-  free_list_.push_front(frame_id);
-  page.page_id_ = INVALID_PAGE_ID;
-  return true;
+  // Write a new file and rename it over the old one, which replaces the old dump atomically.
+  const std::string tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    const uint32_t header[2] = {POOL_DUMP_MAGIC, static_cast<uint32_t>(page_ids.size())};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    out.flush();
+    if (!out) {
+      LOG_DEBUG("cannot write buffer pool dump %s", tmp_file_name.c_str());
+      std::remove(tmp_file_name.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
 }
 
-void BufferPoolManager::FlushAllPages() {
-  for (auto &page : *pages_) {
-    if (page.IsDirty()) {
-      FlushPage(page.GetPageId());
+size_t BufferPoolManager::WarmUp(const std::string &file_name, size_t num_threads,
+                                 const std::function<bool(page_id_t)> &is_foreign) {
+  std::ifstream in(file_name, std::ios::binary | std::ios::ate);
+  const auto file_size = static_cast<uint64_t>(in.tellg());
+  uint32_t header[2];
+  if (!in.seekg(0) || !in.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != POOL_DUMP_MAGIC) {
+    return 0;
+  }
+  // A dump lists distinct pages, so a count that does not match the file or exceeds the database is damage.
+  const page_id_t num_disk_pages = disk_manager_->GetNumPages();
+  if (file_size != sizeof(header) + uint64_t{header[1]} * sizeof(page_id_t) ||
+      header[1] > static_cast<uint32_t>(num_disk_pages)) {
+    LOG_DEBUG("ignoring damaged buffer pool dump %s", file_name.c_str());
+    return 0;
+  }
+  // Only the hottest pages fit if the pool is smaller now.
+  std::vector<page_id_t> page_ids(std::min<size_t>(header[1], pool_size_));
+  if (!in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t))) {
+    return 0;
+  }
+
+  // Pages deallocated since the dump are gone for good.
+  const FreeSpaceMap &free_space_map = disk_manager_->GetFreeSpaceMap();
+  auto is_gone = [num_disk_pages, &free_space_map](page_id_t page_id) {
+    return page_id < 0 || page_id >= num_disk_pages || !free_space_map.IsAllocated(page_id);
+  };
+  page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(), is_gone), page_ids.end());
+  if (is_foreign) {
+    page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(), is_foreign), page_ids.end());
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+
+  // Every thread reads a contiguous range of page ids, front to back.
+  num_threads = std::max<size_t>(num_threads, 1);
+  std::atomic<size_t> num_loaded{0};
+  std::vector<std::thread> threads;
+  const size_t range_size = (page_ids.size() + num_threads - 1) / num_threads;
+  for (size_t begin = 0; begin < page_ids.size(); begin += range_size) {
+    const size_t end = std::min(begin + range_size, page_ids.size());
+    threads.emplace_back([this, &page_ids, &num_loaded, begin, end] {
+      for (size_t i = begin; i < end; ++i) {
+        if (FetchPage(page_ids[i]) != nullptr) {
+          UnpinPage(page_ids[i], false);
+          ++num_loaded;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return num_loaded;
+}
+
+void BufferPoolManager::StartPoolDumper(const std::string &file_name) {
+  if (enable_pool_dumper_.exchange(true)) {
+    return;
+  }
+  pool_dump_file_ = file_name;
+  pool_dumper_ = std::make_unique<std::thread>(&BufferPoolManager::RunPoolDumper, this, file_name);
+}
+
+void BufferPoolManager::StopPoolDumper() {
+  {
+    std::lock_guard<std::mutex> guard(pool_dumper_latch_);
+    if (!enable_pool_dumper_.exchange(false)) {
+      return;
     }
   }
+  pool_dumper_cv_.notify_all();
+  pool_dumper_->join();
+  pool_dumper_.reset();
+  DumpResidentPages(pool_dump_file_);
 }
 
-void BufferPoolManager::ResetPage(frame_id_t frame_id, page_id_t page_id) {
-  auto &page = pages_->at(frame_id);
-  page.page_id_ = page_id;
-  page.pin_count_ = 1;
-  page.ResetMemory();
+void BufferPoolManager::RunPoolDumper(const std::string &file_name) {
+  std::unique_lock<std::mutex> lock(pool_dumper_latch_);
+  while (enable_pool_dumper_) {
+    pool_dumper_cv_.wait_for(lock, pool_dump_interval, [this] { return !enable_pool_dumper_; });
+    if (!enable_pool_dumper_) {
+      break;
+    }
+    lock.unlock();
+    DumpResidentPages(file_name);
+    lock.lock();
+  }
 }
 
-bool BufferPoolManager::CheckAllPinned() const { return free_list_.empty() && (replacer_->Size() == 0); }
+BufferPoolMetrics BufferPoolManager::GetMetrics() const {
+  BufferPoolMetrics metrics = counters_.Snapshot();
+  for (const auto &instance : instances_) {
+    metrics += instance->GetMetrics();
+  }
+  return metrics;
+}
 
-bool BufferPoolManager::ObtainFreeFrame(frame_id_t *frame_id) {
-  if (!free_list_.empty()) {
-    *frame_id = free_list_.front();
-    free_list_.pop_front();
-    return true;
+std::vector<BufferPoolMetrics> BufferPoolManager::GetInstanceMetrics() const {
+  std::vector<BufferPoolMetrics> metrics;
+  for (const auto &instance : instances_) {
+    metrics.push_back(instance->GetMetrics());
   }
+  return metrics;
+}
 
-  if (!replacer_->Victim(frame_id)) {
-    // LOG_ERROR("Find replacer free frame failure");
-    return false;
+std::string BufferPoolManager::GetMetricsReport() const {
+  std::ostringstream os;
+  os << "buffer pool: pool_size=" << pool_size_ << " " << GetMetrics().ToString() << "\n";
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    os << "  instance " << i << ": pool_size=" << instances_[i]->GetPoolSize() << " "
+       << instances_[i]->GetMetrics().ToString() << "\n";
+  }
+  return os.str();
+}
+
+void BufferPoolManager::StartMetricsReporter(const std::string &file_name) {
+  if (enable_metrics_reporter_.exchange(true)) {
+    return;
   }
-  Page &page = pages_->at(page_table_[*frame_id]);
-  const page_id_t page_id = page.GetPageId();
-  page_table_.erase(page_id);
-  if (page.IsDirty()) {
-    disk_manager_->WritePage(page_id, page.GetData());
+  metrics_reporter_ = std::make_unique<std::thread>(&BufferPoolManager::RunMetricsReporter, this, file_name);
+}
+
+void BufferPoolManager::StopMetricsReporter() {
+  {
+    std::lock_guard<std::mutex> guard(metrics_reporter_latch_);
+    if (!enable_metrics_reporter_.exchange(false)) {
+      return;
+    }
+  }
+  metrics_reporter_cv_.notify_all();
+  metrics_reporter_->join();
+  metrics_reporter_.reset();
+}
+
+void BufferPoolManager::RunMetricsReporter(const std::string &file_name) {
+  std::ofstream out(file_name, std::ios::app);
+  std::unique_lock<std::mutex> lock(metrics_reporter_latch_);
+  while (enable_metrics_reporter_) {
+    metrics_reporter_cv_.wait_for(lock, metrics_report_interval, [this] { return !enable_metrics_reporter_; });
+    if (!enable_metrics_reporter_) {
+      break;
+    }
+    lock.unlock();
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    out << "time_ms=" << now.count() << " " << GetMetricsReport() << std::flush;
+    lock.lock();
+  }
+}
+
+bool BufferPoolManager::Resize(size_t new_size) {
+  BUSTUB_ASSERT(new_size >= instances_.size(), "Every instance needs at least one frame.");
+  std::lock_guard<std::mutex> guard(resize_latch_);
+  bool resized = true;
+  size_t pool_size = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    resized = instances_[i]->Resize(GetInstanceSize(new_size, instances_.size(), i), resize_drain_timeout) && resized;
+    pool_size += instances_[i]->GetPoolSize();
+  }
+  pool_size_ = pool_size;
+  return resized;
+}
+
+Page *BufferPoolManager::GetFrame(size_t index) const {
+  for (const auto &instance : instances_) {
+    if (index < instance->GetPoolSize()) {
+      return instance->GetFrame(static_cast<frame_id_t>(index));
+    }
+    index -= instance->GetPoolSize();
+  }
+  return nullptr;
+}
+
+bool BufferPoolManager::CheckAllPinned() const {
+  for (const auto &instance : instances_) {
+    if (!instance->CheckAllPinned()) {
+      return false;
+    }
   }
   return true;
 }
+
 }  // namespace bustub
@@ -0,0 +1,582 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_instance.cpp
+//
+// Identification: src/buffer/buffer_pool_manager_instance.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : pool_size_(0), target_size_(0), frames_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+  page_tables_.emplace_back(std::make_unique<PageTable>(pool_size));
+  page_table_ = page_tables_.back().get();
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = std::make_unique<ClockReplacer>(pool_size);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = std::make_unique<LRUKReplacer>(pool_size);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = std::make_unique<LRUReplacer>(pool_size);
+      break;
+  }
+
+  // Initially, every frame is in the free list.
+  std::lock_guard<std::mutex> guard(latch_);
+  Grow(pool_size);
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  std::unique_lock<std::mutex> lock(latch_);
+  io_done_.wait(lock, [&] { return pending_reads_.empty() && pending_writes_.empty(); });
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, BufferRing *ring) {
+  // Fast path: the page is resident and not busy.
+  frame_id_t frame_id;
+  if (Table().Find(page_id, &frame_id) && TryPin(frame_id, page_id)) {
+    counters_.Add(BufferPoolCounter::HITS);
+    MarkSharedUse(frame_id, ring);
+    return &Frame(frame_id);
+  }
+
+  std::unique_lock<std::mutex> lock = LockLatch();
+  // If a prefetch is reading the page right now, wait for it instead of reading the page a second time. If the page
+  // was just evicted, wait for its write-back, or the read would see a stale copy.
+  io_done_.wait(lock, [&] { return !HasPendingIO(page_id); });
+  // Under the latch, the page table is exact and a resident page without pending I/O is not busy.
+  if (Table().Find(page_id, &frame_id)) {
+    Frame(frame_id).pin_count_++;
+    counters_.Add(BufferPoolCounter::HITS);
+    MarkSharedUse(frame_id, ring);
+    return &Frame(frame_id);
+  }
+
+  if (!(ring != nullptr && ObtainRingFrame(ring, &frame_id)) && !ObtainFreeFrame(&frame_id)) {
+    counters_.Add(BufferPoolCounter::NO_FREE_FRAME);
+    return nullptr;
+  }
+  Page &page = Frame(frame_id);
+  ResetPage(frame_id, page_id);
+  disk_manager_->ReadPage(page_id, page.GetData());
+  counters_.Add(BufferPoolCounter::MISSES);
+  page.EndChange();
+  page.pin_count_ = 1;
+  Table().Insert(page_id, frame_id);
+  if (ring != nullptr) {
+    ring->Push(frame_id, page_id);
+  }
+  return &page;
+}
+
+Page *BufferPoolManagerInstance::FetchPageOptimistic(page_id_t page_id, uint64_t *version) {
+  frame_id_t frame_id;
+  if (!Table().Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  // If the frame changes hands after the snapshot, validation fails. If it did before, it holds another page now.
+  Page &page = Frame(frame_id);
+  if (!page.BeginOptimisticRead(version) || page.GetPageId() != page_id) {
+    return nullptr;
+  }
+  return &page;
+}
+
+Page *BufferPoolManagerInstance::FetchResidentPage(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (!Table().Find(page_id, &frame_id) || !TryPin(frame_id, page_id)) {
+    return nullptr;
+  }
+  counters_.Add(BufferPoolCounter::HITS);
+  return &Frame(frame_id);
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id;
+  if (!Table().Find(page_id, &frame_id)) {
+    // A lock-free lookup can miss an entry that is being moved; only the latch makes a miss certain.
+    std::unique_lock<std::mutex> lock = LockLatch();
+    if (!Table().Find(page_id, &frame_id)) {
+      return false;
+    }
+  }
+
+  // A caller that really holds a pin keeps the frame from changing under us.
+  Page &page = Frame(frame_id);
+  if (is_dirty) {
+    page.is_dirty_ = true;
+  }
+  int pin_count = page.pin_count_;
+  do {
+    if (pin_count <= 0 || page.GetPageId() != page_id) {
+      LOG_ERROR("page id: %d, pin count: %d", page_id, page.GetPinCount());
+      return false;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1) {
+    UnpinFrame(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (!Table().Find(page_id, &frame_id)) {
+    return false;
+  }
+
+  Page &page = Frame(frame_id);
+  // Clear the flag first: whoever dirties the page while it is being written sets it again.
+  if (page.is_dirty_.exchange(false)) {
+    const auto start = std::chrono::steady_clock::now();
+    disk_manager_->WritePage(page_id, page.GetData());
+    counters_.Add(BufferPoolCounter::FLUSHES);
+    counters_.AddTimeSince(BufferPoolCounter::FLUSH_TIME_US, start);
+  }
+  return true;
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  // The page id may have been used before; its last write-back must not overwrite the new page later.
+  io_done_.wait(lock, [&] { return !HasPendingIO(page_id); });
+  frame_id_t frame_id;
+  // A frame may still hold what the page id contained before, e.g. read by a prefetch. It is dropped, so that no two
+  // frames ever hold the same page.
+  if (Table().Find(page_id, &frame_id)) {
+    if (!TryMakeBusy(frame_id)) {
+      LOG_ERROR("page id: %d is reused while pinned", page_id);
+      return nullptr;
+    }
+    DropFrame(frame_id);
+  }
+  if (!ObtainFreeFrame(&frame_id)) {
+    counters_.Add(BufferPoolCounter::NO_FREE_FRAME);
+    return nullptr;
+  }
+  ResetPage(frame_id, page_id);
+  Frame(frame_id).EndChange();
+  Frame(frame_id).pin_count_ = 1;
+  Table().Insert(page_id, frame_id);
+  return &Frame(frame_id);
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  // The background writer may be writing the page back; its frame is busy until then.
+  io_done_.wait(lock, [&] { return !HasPendingIO(page_id); });
+  frame_id_t frame_id;
+  if (!Table().Find(page_id, &frame_id)) {
+    return true;
+  }
+
+  if (!TryMakeBusy(frame_id)) {
+    return false;
+  }
+  DropFrame(frame_id);
+  return true;
+}
+
+Page *BufferPoolManagerInstance::BeginPrefetch(page_id_t page_id, BufferRing *ring) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (Table().Find(page_id, &frame_id) || pending_writes_.count(page_id) != 0) {
+    return nullptr;
+  }
+
+  if (!(ring != nullptr && ObtainRingFrame(ring, &frame_id)) && !ObtainFreeFrame(&frame_id)) {
+    return nullptr;
+  }
+  // The frame stays busy until the read completes, so lock-free fetches fall back to waiting under the latch.
+  ResetPage(frame_id, page_id);
+  Table().Insert(page_id, frame_id);
+  pending_reads_.insert(page_id);
+  if (ring != nullptr) {
+    ring->Push(frame_id, page_id);
+  }
+  return &Frame(frame_id);
+}
+
+void BufferPoolManagerInstance::CompletePrefetch(page_id_t page_id, bool ok) {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    pending_reads_.erase(page_id);
+    frame_id_t frame_id;
+    // Under the latch, the page table is exact, and nobody takes the frame of a page that is being read.
+    if (!Table().Find(page_id, &frame_id)) {
+      UNREACHABLE("A page being prefetched lost its frame.");
+    }
+    Page &page = Frame(frame_id);
+    if (ok) {
+      page.EndChange();
+      page.pin_count_ = 0;
+      MakeEvictable(frame_id);
+    } else {
+      // Whoever waits for the read fetches the page again. The frame is still busy, just like a free one.
+      Table().Erase(page_id);
+      page.page_id_ = INVALID_PAGE_ID;
+      if (IsRetiring(frame_id)) {
+        RetireFrame(frame_id);
+      } else {
+        free_list_.push_front(frame_id);
+      }
+    }
+  }
+  io_done_.notify_all();
+}
+
+std::vector<Page *> BufferPoolManagerInstance::PinDirtyPages() {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < pool_size_; ++i) {
+    // Under the latch, a busy frame is free or waiting for a prefetch read; neither holds a dirty page.
+    Page &page = Frame(i);
+    if (page.GetPageId() != INVALID_PAGE_ID && page.pin_count_ >= 0 && page.is_dirty_.exchange(false)) {
+      page.pin_count_++;
+      pages.push_back(&page);
+    }
+  }
+  return pages;
+}
+
+size_t BufferPoolManagerInstance::CleanColdFrames(size_t num_clean_frames, size_t max_writes) {
+  std::vector<frame_id_t> cold_frames;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (free_list_.size() >= num_clean_frames) {
+      return 0;
+    }
+    cold_frames = replacer_->PeekVictims(num_clean_frames - free_list_.size());
+  }
+
+  size_t num_writes = 0;
+  for (frame_id_t frame_id : cold_frames) {
+    if (num_writes >= max_writes) {
+      break;
+    }
+    // Take the latch once per page, so that foreground requests get in between. The frame may have been pinned or
+    // reused since we looked at it.
+    std::unique_lock<std::mutex> guard(latch_);
+    Page &page = Frame(frame_id);
+    if (page.GetPageId() == INVALID_PAGE_ID || !page.IsDirty()) {
+      continue;
+    }
+    // Write-ahead logging: a page may only reach the disk after the log records that changed it.
+    if (enable_logging && log_manager_ != nullptr && page.GetLSN() > log_manager_->GetPersistentLSN()) {
+      continue;
+    }
+    // Keep lock-free pins off the page while it is written, or a change made meanwhile could lose its dirty flag. Like
+    // a prefetched page, the page stays marked as having I/O in flight, so fetches under the latch wait for the write.
+    if (!TryMakeBusy(frame_id)) {
+      continue;
+    }
+    const page_id_t page_id = page.GetPageId();
+    page.is_dirty_ = false;
+    pending_writes_.insert(page_id);
+    ++num_writes;
+    guard.unlock();
+    disk_manager_->WritePageAsync(page_id, page.GetData(), [this, frame_id, page_id](bool ok) {
+      {
+        std::lock_guard<std::mutex> guard(latch_);
+        pending_writes_.erase(page_id);
+        Page &page = Frame(frame_id);
+        if (!ok) {
+          page.is_dirty_ = true;
+        }
+        page.pin_count_ = 0;
+        // The replacer drops frames it hands out while they are busy.
+        if (!page.in_replacer_) {
+          MakeEvictable(frame_id);
+        }
+      }
+      io_done_.notify_all();
+    });
+  }
+  return num_writes;
+}
+
+bool BufferPoolManagerInstance::Resize(size_t new_size, std::chrono::milliseconds timeout) {
+  BUSTUB_ASSERT(new_size > 0, "Every instance needs at least one frame.");
+  std::unique_lock<std::mutex> lock(latch_);
+  const size_t old_size = pool_size_;
+  if (new_size >= old_size) {
+    Grow(new_size);
+    return true;
+  }
+
+  // From now on, nobody gets the frames from new_size on. Each of them is retired as soon as it is free or unpinned.
+  target_size_ = new_size;
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    DrainRetiringFrames();
+    if (retired_frames_.size() == old_size - new_size) {
+      break;
+    }
+    // Frames are unpinned without the latch and without a signal, so check back every now and then.
+    if (std::chrono::steady_clock::now() >= deadline) {
+      for (frame_id_t frame_id : retired_frames_) {
+        free_list_.push_back(frame_id);
+      }
+      retired_frames_.clear();
+      target_size_ = old_size;
+      return false;
+    }
+    io_done_.wait_for(lock, std::chrono::milliseconds(1));
+  }
+
+  for (frame_id_t frame_id : retired_frames_) {
+    frames_.Release(frame_id);
+  }
+  retired_frames_.clear();
+  replacer_->Resize(new_size);
+  pool_size_ = new_size;
+  return true;
+}
+
+bool BufferPoolManagerInstance::CheckAllPinned() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return free_list_.empty() && replacer_->Size() == 0;
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetResidentPages() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> victims = replacer_->PeekVictims(pool_size_);
+  std::vector<bool> in_victims(pool_size_, false);
+  for (frame_id_t frame_id : victims) {
+    in_victims[frame_id] = true;
+  }
+  // Pages the replacer does not hold are pinned or were pinned without the latch: they are the hottest ones.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < pool_size_; ++i) {
+    const page_id_t page_id = Frame(i).GetPageId();
+    if (!in_victims[i] && page_id != INVALID_PAGE_ID) {
+      page_ids.push_back(page_id);
+    }
+  }
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) {
+    const page_id_t page_id = Frame(*it).GetPageId();
+    if (page_id != INVALID_PAGE_ID) {
+      page_ids.push_back(page_id);
+    }
+  }
+  return page_ids;
+}
+
+bool BufferPoolManagerInstance::TryPin(frame_id_t frame_id, page_id_t page_id) {
+  Page &page = Frame(frame_id);
+  int pin_count = page.pin_count_;
+  do {
+    if (pin_count < 0) {
+      return false;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  // The page table entry may have been stale: the frame was evicted and now holds another page.
+  if (page.GetPageId() != page_id) {
+    if (page.pin_count_.fetch_sub(1) == 1) {
+      UnpinFrame(frame_id);
+    }
+    return false;
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  // The frame usually is still in the replacer, since lock-free pins do not take it out. Then the replacer only
+  // misses a use of the frame, which is worth recording when the latch happens to be free but not worth waiting for.
+  if (Frame(frame_id).in_replacer_) {
+    std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+    if (lock.owns_lock() && Frame(frame_id).in_replacer_ && Frame(frame_id).pin_count_ == 0) {
+      MakeEvictable(frame_id);
+    }
+    return;
+  }
+  // The replacer dropped the frame while it was pinned; without it, the frame could never be evicted again.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  if (Frame(frame_id).pin_count_ == 0) {
+    MakeEvictable(frame_id);
+  }
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    const auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    counters_.Add(BufferPoolCounter::LATCH_WAITS);
+    counters_.AddTimeSince(BufferPoolCounter::LATCH_WAIT_TIME_US, start);
+  }
+  return lock;
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  Page &page = Frame(frame_id);
+  page.page_id_ = INVALID_PAGE_ID;
+  page.is_dirty_ = false;
+  retired_frames_.insert(frame_id);
+}
+
+void BufferPoolManagerInstance::Grow(size_t new_size) {
+  // Frames past the pool size are busy and hold no page, so lock-free pins and optimistic reads fail on them.
+  frames_.Reserve(new_size);
+  for (; num_prepared_frames_ < frames_.Capacity(); ++num_prepared_frames_) {
+    Page &page = Frame(num_prepared_frames_);
+    page.pin_count_ = FRAME_BUSY;
+    page.BeginChange();
+  }
+  if (Table().MaxEntries() < new_size) {
+    auto table = std::make_unique<PageTable>(std::max(new_size, 2 * Table().MaxEntries()));
+    Table().ForEach([&table](page_id_t page_id, frame_id_t frame_id) { table->Insert(page_id, frame_id); });
+    page_table_ = table.get();
+    page_tables_.push_back(std::move(table));
+  }
+  replacer_->Resize(new_size);
+  for (size_t i = pool_size_; i < new_size; ++i) {
+    free_list_.emplace_back(static_cast<frame_id_t>(i));
+  }
+  pool_size_ = new_size;
+  target_size_ = new_size;
+}
+
+void BufferPoolManagerInstance::DrainRetiringFrames() {
+  for (auto it = free_list_.begin(); it != free_list_.end();) {
+    if (IsRetiring(*it)) {
+      RetireFrame(*it);
+      it = free_list_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (size_t i = target_size_; i < pool_size_; ++i) {
+    const auto frame_id = static_cast<frame_id_t>(i);
+    if (retired_frames_.count(frame_id) != 0 || !TryMakeBusy(frame_id)) {
+      continue;
+    }
+    replacer_->Pin(frame_id);
+    Frame(frame_id).in_replacer_ = false;
+    EvictFrame(frame_id);
+    RetireFrame(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::DropFrame(frame_id_t frame_id) {
+  Page &page = Frame(frame_id);
+  Table().Erase(page.GetPageId());
+  // The frame is unpinned, so it may sit in the replacer; take it out before handing it back to the free list.
+  replacer_->Pin(frame_id);
+  page.in_replacer_ = false;
+  page.BeginChange();
+  page.page_id_ = INVALID_PAGE_ID;
+  page.is_dirty_ = false;
+  if (IsRetiring(frame_id)) {
+    RetireFrame(frame_id);
+  } else {
+    free_list_.push_front(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::ResetPage(frame_id_t frame_id, page_id_t page_id) {
+  Page &page = Frame(frame_id);
+  page.page_id_ = page_id;
+  page.is_dirty_ = false;
+  page.shared_use_ = false;
+  page.ResetMemory();
+}
+
+bool BufferPoolManagerInstance::ObtainFreeFrame(frame_id_t *frame_id) {
+  // A shrink takes the retiring free frames off the list, but pages deleted meanwhile may have put some back.
+  while (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    if (!IsRetiring(*frame_id)) {
+      return true;
+    }
+    RetireFrame(*frame_id);
+  }
+
+  // The replacer may hand out frames that were pinned without the latch; those are dropped until they are unpinned.
+  while (replacer_->Victim(frame_id)) {
+    Frame(*frame_id).in_replacer_ = false;
+    if (TryMakeBusy(*frame_id)) {
+      EvictFrame(*frame_id);
+      if (!IsRetiring(*frame_id)) {
+        return true;
+      }
+      RetireFrame(*frame_id);
+    }
+  }
+  return false;
+}
+
+bool BufferPoolManagerInstance::ObtainRingFrame(BufferRing *ring, frame_id_t *frame_id) {
+  if (!ring->IsFull()) {
+    return false;
+  }
+  // The oldest frame is dropped from the ring either way. If someone else fetched its page without a ring since the
+  // scan read it, or has it pinned right now, the page has become part of the shared working set and is left to the
+  // replacer.
+  const auto [ring_frame_id, ring_page_id] = ring->Pop();
+  if (Frame(ring_frame_id).GetPageId() != ring_page_id || !TryMakeBusy(ring_frame_id)) {
+    return false;
+  }
+  // Checked once the frame is busy, so that no fetch can slip in between.
+  if (Frame(ring_frame_id).shared_use_.load(std::memory_order_relaxed)) {
+    Frame(ring_frame_id).pin_count_ = 0;
+    return false;
+  }
+  replacer_->Pin(ring_frame_id);
+  Frame(ring_frame_id).in_replacer_ = false;
+  EvictFrame(ring_frame_id);
+  if (IsRetiring(ring_frame_id)) {
+    RetireFrame(ring_frame_id);
+    return false;
+  }
+  *frame_id = ring_frame_id;
+  return true;
+}
+
+void BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id) {
+  Page &page = Frame(frame_id);
+  page.BeginChange();
+  const page_id_t page_id = page.GetPageId();
+  Table().Erase(page_id);
+  counters_.Add(BufferPoolCounter::EVICTIONS);
+  if (!page.IsDirty()) {
+    return;
+  }
+  counters_.Add(BufferPoolCounter::DIRTY_EVICTIONS);
+  // The frame is reused as soon as we return, so the write goes out from a copy. The copy is page aligned, which
+  // spares the disk manager a bounce buffer under O_DIRECT.
+  std::shared_ptr<char> copy(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)), free);
+  memcpy(copy.get(), page.GetData(), PAGE_SIZE);
+  pending_writes_.insert(page_id);
+  disk_manager_->WritePageAsync(page_id, copy.get(), [this, page_id, copy](bool) {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      pending_writes_.erase(page_id);
+    }
+    io_done_.notify_all();
+  });
+}
+
+}  // namespace bustub
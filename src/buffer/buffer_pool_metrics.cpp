@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.cpp
+//
+// Identification: src/buffer/buffer_pool_metrics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_metrics.h"
+
+#include <functional>
+#include <sstream>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+BufferPoolMetrics &BufferPoolMetrics::operator+=(const BufferPoolMetrics &that) {
+  hits += that.hits;
+  misses += that.misses;
+  evictions += that.evictions;
+  dirty_evictions += that.dirty_evictions;
+  no_free_frame += that.no_free_frame;
+  flushes += that.flushes;
+  flush_time_us += that.flush_time_us;
+  latch_waits += that.latch_waits;
+  latch_wait_time_us += that.latch_wait_time_us;
+  return *this;
+}
+
+std::string BufferPoolMetrics::ToString() const {
+  std::ostringstream os;
+  os.precision(4);
+  os << "hits=" << hits << " misses=" << misses << " hit_ratio=" << HitRatio() << " evictions=" << evictions
+     << " dirty_evictions=" << dirty_evictions << " no_free_frame=" << no_free_frame << " flushes=" << flushes
+     << " flush_time_us=" << flush_time_us << " latch_waits=" << latch_waits
+     << " latch_wait_time_us=" << latch_wait_time_us;
+  return os.str();
+}
+
+BufferPoolMetrics BufferPoolCounters::Snapshot() const {
+  std::array<uint64_t, NUM_COUNTERS> sums{};
+  for (const auto &stripe : stripes_) {
+    for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+      sums[i] += stripe.counts_[i].load(std::memory_order_relaxed);
+    }
+  }
+  auto sum = [&sums](BufferPoolCounter counter) { return sums[static_cast<size_t>(counter)]; };
+  BufferPoolMetrics metrics;
+  metrics.hits = sum(BufferPoolCounter::HITS);
+  metrics.misses = sum(BufferPoolCounter::MISSES);
+  metrics.evictions = sum(BufferPoolCounter::EVICTIONS);
+  metrics.dirty_evictions = sum(BufferPoolCounter::DIRTY_EVICTIONS);
+  metrics.no_free_frame = sum(BufferPoolCounter::NO_FREE_FRAME);
+  metrics.flushes = sum(BufferPoolCounter::FLUSHES);
+  metrics.flush_time_us = sum(BufferPoolCounter::FLUSH_TIME_US);
+  metrics.latch_waits = sum(BufferPoolCounter::LATCH_WAITS);
+  metrics.latch_wait_time_us = sum(BufferPoolCounter::LATCH_WAIT_TIME_US);
+  return metrics;
+}
+
+size_t BufferPoolCounters::StripeIndex() {
+  thread_local const size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_STRIPES;
+  return index;
+}
+
+}  // namespace bustub
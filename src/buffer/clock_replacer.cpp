@@ -12,43 +12,96 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages),
+      in_replacer_((num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD, 0),
+      ref_((num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD, 0) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
 bool ClockReplacer::Victim(frame_id_t *frame_id) {
-  if (page_table_.empty()) {
+  if (size_ == 0) {
     return false;
   }
-  for (auto &it : pages_) {
-    if (it.second == true) {
-      it.second = false;
-    } else {
-      const auto id = it.first;
-      *frame_id = id;
-      pages_.remove_if([id](auto &e) { return id == e.first; });
-      page_table_.erase(id);
-      return true;
+  // Every frame in the replacer has its bit cleared within one sweep, so this finds a victim within two sweeps.
+  while (true) {
+    const size_t word = clock_hand_ / BITS_PER_WORD;
+    const size_t offset = clock_hand_ % BITS_PER_WORD;
+    // The frames of this word in the replacer, from the hand on.
+    const uint64_t ahead = in_replacer_[word] >> offset << offset;
+    const uint64_t unreferenced = ahead & ~ref_[word];
+    if (unreferenced == 0) {
+      ref_[word] &= ~ahead;
+      clock_hand_ = (word + 1) * BITS_PER_WORD;
+      if (clock_hand_ >= num_pages_) {
+        clock_hand_ = 0;
+      }
+      continue;
     }
+    // The hand clears the bits of the frames it passes on the way to the victim.
+    const auto bit = static_cast<size_t>(__builtin_ctzll(unreferenced));
+    const uint64_t passed = ahead & ((uint64_t{1} << bit) - 1);
+    ref_[word] &= ~passed;
+    in_replacer_[word] &= ~(uint64_t{1} << bit);
+    --size_;
+    const size_t frame = word * BITS_PER_WORD + bit;
+    clock_hand_ = (frame + 1) % num_pages_;
+    *frame_id = static_cast<frame_id_t>(frame);
+    return true;
   }
-  return false;
 }
 
 void ClockReplacer::Pin(frame_id_t frame_id) {
-  if (page_table_.empty() || page_table_.find(frame_id) == page_table_.end()) {
-    return;
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  if ((in_replacer_[Word(frame_id)] & Bit(frame_id)) != 0) {
+    in_replacer_[Word(frame_id)] &= ~Bit(frame_id);
+    --size_;
   }
-  page_table_.erase(frame_id);
-  pages_.remove_if([id = frame_id](auto &e) { return e.first == id; });
 }
 
 void ClockReplacer::Unpin(frame_id_t frame_id) {
-  if (page_table_.find(frame_id) == page_table_.end() && page_table_.size() < num_pages_) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  if ((in_replacer_[Word(frame_id)] & Bit(frame_id)) == 0) {
+    in_replacer_[Word(frame_id)] |= Bit(frame_id);
+    ++size_;
+  }
+  ref_[Word(frame_id)] |= Bit(frame_id);
+}
+
+size_t ClockReplacer::Size() { return size_; }
+
+void ClockReplacer::Resize(size_t num_pages) {
+  // Frames past the new end leave the replacer, including those sharing the last word with the remaining ones.
+  for (size_t frame = num_pages; frame < num_pages_ && frame % BITS_PER_WORD != 0; ++frame) {
+    Pin(static_cast<frame_id_t>(frame));
+  }
+  for (size_t word = (num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD; word < in_replacer_.size(); ++word) {
+    size_ -= __builtin_popcountll(in_replacer_[word]);
+  }
+  num_pages_ = num_pages;
+  in_replacer_.resize((num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+  ref_.resize(in_replacer_.size(), 0);
+  if (clock_hand_ >= num_pages) {
+    clock_hand_ = 0;
   }
 }
 
-size_t ClockReplacer::Size() { return page_table_.size(); }
+std::vector<frame_id_t> ClockReplacer::PeekVictims(size_t max_frames) {
+  // The hand takes the frames with a clear reference bit in ring order, then comes around again for the rest.
+  std::vector<frame_id_t> frames;
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < num_pages_ && frames.size() < max_frames; ++i) {
+      const auto frame = static_cast<frame_id_t>((clock_hand_ + i) % num_pages_);
+      if ((in_replacer_[Word(frame)] & Bit(frame)) != 0 && ((ref_[Word(frame)] & Bit(frame)) != 0) == referenced) {
+        frames.push_back(frame);
+      }
+    }
+  }
+  return frames;
+}
 
 }  // namespace bustub
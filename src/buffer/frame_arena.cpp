@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Maps size bytes of anonymous memory for frame data. Sizes of at least HUGE_PAGE_SIZE are backed by huge pages:
+ * reserved ones if possible, transparent ones otherwise.
+ * @param[in,out] size the number of bytes needed; rounded up to whole huge pages if they back the memory
+ * @param[out] huge_tlb true if the memory is backed by reserved huge pages
+ * @return the memory, MAP_FAILED if it could not be mapped
+ */
+void *MapFrameData(size_t *size, bool *huge_tlb) {
+  *huge_tlb = false;
+  if (*size < HUGE_PAGE_SIZE) {
+    return mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  *size = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  void *data = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (data != MAP_FAILED) {
+    *huge_tlb = true;
+    return data;
+  }
+
+  // No reserved huge pages left: map a bit more, trim it to a huge page boundary and ask for transparent huge pages.
+  data = mmap(nullptr, *size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    return data;
+  }
+  auto *begin = static_cast<char *>(data);
+  const size_t head = (HUGE_PAGE_SIZE - reinterpret_cast<uintptr_t>(begin) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+  if (head > 0) {
+    munmap(begin, head);
+  }
+  munmap(begin + head + *size, HUGE_PAGE_SIZE - head);
+#ifdef MADV_HUGEPAGE
+  // Only a hint; the memory works the same without it.
+  madvise(begin + head, *size, MADV_HUGEPAGE);
+#endif
+  return begin + head;
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t first_chunk_size) : first_chunk_size_(first_chunk_size) {
+  BUSTUB_ASSERT(first_chunk_size > 0, "The first chunk needs at least one frame.");
+}
+
+FrameArena::~FrameArena() {
+  for (size_t chunk = 0; chunk < num_chunks_; ++chunk) {
+    delete[] chunks_[chunk].load();
+    munmap(data_[chunk], data_size_[chunk]);
+  }
+}
+
+void FrameArena::Reserve(size_t num_frames) {
+  while (Capacity() < num_frames) {
+    if (num_chunks_ == MAX_CHUNKS) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "too many frames for one buffer pool instance");
+    }
+    const size_t chunk_size = first_chunk_size_ << num_chunks_;
+    size_t data_size = chunk_size * PAGE_SIZE;
+    bool huge_tlb;
+    void *data = MapFrameData(&data_size, &huge_tlb);
+    if (data == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map memory for buffer pool frames");
+    }
+    auto *pages = new Page[chunk_size];
+    for (size_t i = 0; i < chunk_size; ++i) {
+      pages[i].data_ = static_cast<char *>(data) + i * PAGE_SIZE;
+    }
+    data_[num_chunks_] = static_cast<char *>(data);
+    data_size_[num_chunks_] = data_size;
+    huge_tlb_[num_chunks_] = huge_tlb;
+    chunks_[num_chunks_].store(pages, std::memory_order_release);
+    ++num_chunks_;
+  }
+}
+
+void FrameArena::Release(frame_id_t frame_id) {
+  // Reserved huge pages can only be given back as a whole, which happens when the arena goes away.
+  if (!huge_tlb_[ChunkOf(frame_id)]) {
+    madvise(GetFrame(frame_id)->GetData(), PAGE_SIZE, MADV_DONTNEED);
+  }
+}
+
+size_t FrameArena::NumHugeTlbChunks() const {
+  size_t num_huge_tlb_chunks = 0;
+  for (size_t chunk = 0; chunk < num_chunks_; ++chunk) {
+    num_huge_tlb_chunks += huge_tlb_[chunk] ? 1 : 0;
+  }
+  return num_huge_tlb_chunks;
+}
+
+}  // namespace bustub
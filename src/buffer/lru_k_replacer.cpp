@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : num_pages_(num_pages), k_(k), history_(num_pages), is_evictable_(num_pages, false) {
+  BUSTUB_ASSERT(k_ > 0, "LRU-K needs to remember at least one access.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+// Victim(T*): Remove the evictable frame with the largest backward K-distance and forget its history, since the
+// frame is about to hold a different page.
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (evictable_.empty()) {
+    return false;
+  }
+  const frame_id_t victim = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  is_evictable_[victim] = false;
+  history_[victim].clear();
+  *frame_id = victim;
+  return true;
+}
+
+// Pin(T): The frame has been accessed and must not be victimized until it is unpinned.
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  if (is_evictable_[frame_id]) {
+    evictable_.erase({KeyOf(frame_id), frame_id});
+    is_evictable_[frame_id] = false;
+  }
+  RecordAccess(frame_id);
+}
+
+// Unpin(T): The pin count of the frame dropped to 0, so it can be victimized again.
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  if (is_evictable_[frame_id]) {
+    return;
+  }
+  if (history_[frame_id].empty()) {
+    RecordAccess(frame_id);
+  }
+  evictable_.emplace(KeyOf(frame_id), frame_id);
+  is_evictable_[frame_id] = true;
+}
+
+size_t LRUKReplacer::Size() { return evictable_.size(); }
+
+void LRUKReplacer::Resize(size_t num_pages) {
+  num_pages_ = num_pages;
+  history_.resize(num_pages);
+  is_evictable_.resize(num_pages, false);
+}
+
+// PeekVictims(n): evictable_ is already sorted in eviction order.
+std::vector<frame_id_t> LRUKReplacer::PeekVictims(size_t max_frames) {
+  std::vector<frame_id_t> frames;
+  for (auto it = evictable_.begin(); it != evictable_.end() && frames.size() < max_frames; ++it) {
+    frames.push_back(it->second);
+  }
+  return frames;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  auto &history = history_[frame_id];
+  history.push_back(current_timestamp_++);
+  if (history.size() > k_) {
+    history.pop_front();
+  }
+}
+
+LRUKReplacer::EvictionKey LRUKReplacer::KeyOf(frame_id_t frame_id) const {
+  const auto &history = history_[frame_id];
+  return {history.size() >= k_, history.front()};
+}
+
+}  // namespace bustub
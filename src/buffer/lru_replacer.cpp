@@ -60,4 +60,16 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
 // Size() : This method returns the number of frames that are currently.
 size_t LRUReplacer::Size() { return pages_.size(); }
 
+// Resize(n) : The list holds no more than num_pages_ frames, and frames past the new number are not among them.
+void LRUReplacer::Resize(size_t num_pages) { num_pages_ = num_pages; }
+
+// PeekVictims(n) : The least recently used frames are at the back of the list.
+std::vector<frame_id_t> LRUReplacer::PeekVictims(size_t max_frames) {
+  std::vector<frame_id_t> frames;
+  for (auto it = pages_.rbegin(); it != pages_.rend() && frames.size() < max_frames; ++it) {
+    frames.push_back(*it);
+  }
+  return frames;
+}
+
 }  // namespace bustub
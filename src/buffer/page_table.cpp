@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t max_entries) : max_entries_(max_entries) {
+  int bits = 1;
+  while ((size_t{1} << bits) < 2 * max_entries) {
+    ++bits;
+  }
+  const size_t num_slots = size_t{1} << bits;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(num_slots);
+  for (size_t i = 0; i < num_slots; ++i) {
+    slots_[i].store(EMPTY, std::memory_order_relaxed);
+  }
+  mask_ = num_slots - 1;
+  shift_ = 64 - bits;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(2 * size_ < mask_ + 1, "Page table is full.");
+  size_t slot = Home(page_id);
+  while (slots_[slot].load(std::memory_order_relaxed) != EMPTY) {
+    slot = (slot + 1) & mask_;
+  }
+  slots_[slot].store(Pack(page_id, frame_id), std::memory_order_release);
+  ++size_;
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t hole = Home(page_id);
+  for (;; hole = (hole + 1) & mask_) {
+    const uint64_t entry = slots_[hole].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      return false;
+    }
+    if (PageIdOf(entry) == page_id) {
+      break;
+    }
+  }
+
+  // Shift back every later entry of the probe sequence whose home slot does not lie between the hole and itself,
+  // so that no lookup runs into an empty slot before reaching its entry.
+  for (size_t slot = (hole + 1) & mask_;; slot = (slot + 1) & mask_) {
+    const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      break;
+    }
+    const size_t home = Home(PageIdOf(entry));
+    if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+      slots_[hole].store(entry, std::memory_order_release);
+      hole = slot;
+    }
+  }
+  slots_[hole].store(EMPTY, std::memory_order_release);
+  --size_;
+  return true;
+}
+
+}  // namespace bustub
@@ -20,4 +20,12 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds bgwriter_interval = std::chrono::milliseconds(200);
+
+std::chrono::milliseconds pool_dump_interval = std::chrono::seconds(30);
+
+std::chrono::milliseconds metrics_report_interval = std::chrono::seconds(10);
+
+std::chrono::milliseconds resize_drain_timeout = std::chrono::milliseconds(1000);
+
 }  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferRing is the set of frames one scan has read pages into within one BufferPoolManagerInstance, oldest first.
+ * Once the ring is full, the instance recycles the oldest frame of the ring for the next page the scan misses on,
+ * instead of asking the replacer for a victim.
+ */
+class BufferRing {
+ public:
+  /** @param capacity the number of frames the ring may hold */
+  explicit BufferRing(size_t capacity) : capacity_(capacity) {}
+
+  /** @return true if the next miss should recycle a frame of the ring */
+  bool IsFull() const { return frames_.size() >= capacity_; }
+
+  /** Appends a frame that now holds page_id. */
+  void Push(frame_id_t frame_id, page_id_t page_id) { frames_.emplace_back(frame_id, page_id); }
+
+  /** Removes the oldest frame of the ring and returns it together with the page the scan read into it. */
+  std::pair<frame_id_t, page_id_t> Pop() {
+    auto oldest = frames_.front();
+    frames_.pop_front();
+    return oldest;
+  }
+
+ private:
+  const size_t capacity_;
+  std::deque<std::pair<frame_id_t, page_id_t>> frames_;
+};
+
+/**
+ * BufferAccessStrategy lets a large sequential scan run in a small private ring of frames, so that reading a table
+ * once does not evict the working set of every other query. Pages that are already resident are fetched as usual;
+ * only pages the scan itself reads from disk go into the ring.
+ *
+ * A strategy belongs to a single scan and is not thread-safe. Obtain one from BufferPoolManager::GetScanStrategy().
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size the total number of frames the scan may recycle
+   * @param num_instances the number of instances of the buffer pool; the ring is split evenly between them
+   */
+  BufferAccessStrategy(size_t ring_size, size_t num_instances);
+
+  /** @return the ring used for pages owned by the given instance */
+  BufferRing *GetRing(size_t instance) { return &rings_[instance]; }
+
+  /** @return the total number of frames the scan may recycle */
+  size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  const size_t ring_size_;
+  std::vector<BufferRing> rings_;
+};
+
+}  // namespace bustub
@@ -12,30 +12,71 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/extent_allocator.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The pool is split into a number of BufferPoolManagerInstances. Each page id is owned by exactly one instance,
+ * chosen by hashing the page id, so threads working on different pages rarely contend on the same latch.
+ *
+ * FetchPage and NewPage leave it to the caller to unpin the page. FetchPageRead, FetchPageWrite and NewPageGuarded
+ * return guards instead, which also take the page latch where asked to and release latch and pin when they go out of
+ * scope. FetchPageOptimistic does neither: short reads, such as a look at a B+ tree node, read the page without
+ * writing to any shared memory and validate its version afterwards.
+ *
+ * Pages can be prefetched: the asynchronous I/O engine of the disk manager reads them into the pool while the caller
+ * keeps working, so a scan that asks for its next pages ahead of time rarely blocks on the disk. Evicting a dirty page
+ * does not block on the disk either: the page is copied and written back in the background.
+ *
+ * The pool can grow and shrink while it is in use, to trade memory with other processes without a restart.
+ *
+ * An optional background writer periodically writes back dirty pages that are about to be evicted, so that evicting
+ * a page on behalf of a foreground request rarely has to wait for a write.
+ *
+ * Every instance counts hits, misses, evictions, latch waits and the like. GetMetrics() takes a snapshot of them, and
+ * an optional metrics reporter periodically appends one to a text file.
+ *
+ * An optional pool dumper periodically writes the ids of the resident pages to a file. After a restart, WarmUp() reads
+ * them back in before the workload starts, instead of letting it pay for every cold miss.
  */
 class BufferPoolManager {
  public:
   /**
-   * Creates a new BufferPoolManager.
+   * Creates a new BufferPoolManager with a single instance.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
 
+  /**
+   * Creates a new BufferPoolManager partitioned into several instances.
+   * @param num_instances the number of instances the buffer pool is split into
+   * @param pool_size the size of the whole buffer pool, divided evenly between the instances
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy every instance uses to pick victim frames
+   */
+  BufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU);
+
   /**
    * Destroys an existing BufferPoolManager.
    */
@@ -48,6 +89,72 @@ class BufferPoolManager {
    */
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch the requested page on behalf of a scan. If the page has to be read from disk, it goes into the scan's
+   * private ring of frames rather than displacing pages other queries are using.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's access strategy, from GetScanStrategy(); nullptr behaves like FetchPage(page_id)
+   * @return the requested page
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Fetch the requested page, pinned for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, empty if every frame is pinned
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id) { return {this, FetchPage(page_id)}; }
+
+  /**
+   * Fetch the requested page, pinned and read-latched for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, empty if every frame is pinned
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id) { return FetchPageBasic(page_id).UpgradeRead(); }
+
+  /**
+   * Fetch the requested page, pinned and write-latched for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, empty if every frame is pinned
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id) { return FetchPageBasic(page_id).UpgradeWrite(); }
+
+  /**
+   * Find the requested page for an optimistic read, without pinning or latching it. Read the page data, then check
+   * with page->ValidateOptimisticRead(*version) that the page did not change or leave its frame in the meantime.
+   * @param page_id id of page to be read
+   * @param[out] version the version to validate the read against
+   * @return the page, nullptr if it is not resident or is being changed right now; fall back to FetchPageRead then
+   */
+  Page *FetchPageOptimistic(page_id_t page_id, uint64_t *version);
+
+  /**
+   * Pin the requested page if it is resident, without waiting for the buffer pool latch or reading anything from
+   * disk. Optimistic readers use it to pin a page they only know the id of from an unlatched read, which may be stale.
+   * @param page_id id of page to be pinned
+   * @return the pinned page, nullptr if it is not resident or is busy
+   */
+  Page *FetchResidentPage(page_id_t page_id);
+
+  /**
+   * Start reading the requested page into the buffer pool in the background, unless it is already resident. The page
+   * is not pinned; fetch it as usual when it is needed. Pages that do not exist on disk yet or are not allocated are
+   * ignored.
+   * @param page_id id of page to be prefetched
+   * @param strategy if not nullptr, the page goes into the scan's ring of frames
+   */
+  void PrefetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Prefetch the pages first_page_id, first_page_id + 1, ..., first_page_id + count - 1, skipping those that are not
+   * allocated. The range is taken as given; it is up to the caller that the pages belong to it. The reads go to the
+   * disk manager as one batch.
+   * @param first_page_id id of the first page to be prefetched
+   * @param count number of pages to be prefetched
+   * @param strategy if not nullptr, the pages go into the scan's ring of frames
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t count, BufferAccessStrategy *strategy = nullptr);
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -66,9 +173,20 @@ class BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
+   * @param allocator if not nullptr, the page id comes from this allocator instead of the disk manager
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPage(page_id_t *page_id);
+  Page *NewPage(page_id_t *page_id, ExtentAllocator *allocator = nullptr);
+
+  /**
+   * Creates a new page in the buffer pool, pinned for as long as the returned guard lives.
+   * @param[out] page_id id of created page
+   * @param allocator if not nullptr, the page id comes from this allocator instead of the disk manager
+   * @return a guard holding the new page, empty if no new pages could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id, ExtentAllocator *allocator = nullptr) {
+    return {this, NewPage(page_id, allocator)};
+  }
 
   /**
    * Deletes a page from the buffer pool.
@@ -78,44 +196,178 @@ class BufferPoolManager {
   bool DeletePage(page_id_t page_id);
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk. The dirty pages of all instances are written in page id order,
+   * runs of adjacent pages with one vectored write each, and synced once at the end, after the write-backs of evicted
+   * pages still in flight.
    */
   void FlushAllPages();
 
   /**
-   * Reset a frame in the buffer pool.
+   * Grows or shrinks the buffer pool while it is in use. Shrinking evicts the pages in the frames that go away, and
+   * waits up to resize_drain_timeout for each instance to get its pinned ones back. Page pointers stay valid either
+   * way.
+   * @param new_size the new size of the whole buffer pool, divided evenly between the instances
+   * @return false if an instance could not shrink because its pages stayed pinned; it then keeps its old size
    */
-  void ResetPage(frame_id_t frame_id, page_id_t page_id);
+  bool Resize(size_t new_size);
 
   /**
-   *  Obtain a free frame, if not exist a free frame victim a page
+   * @param index index of a frame in the whole buffer pool, counting the frames of one instance after another
+   * @return the frame, for tests to look at
    */
-  bool ObtainFreeFrame(frame_id_t *frame_id);
-
-  /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() const { return pages_.get()->data(); }
+  Page *GetFrame(size_t index) const;
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /** @return number of instances the buffer pool is split into */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return true if every instance has all of its frames pinned */
   bool CheckAllPinned() const;
 
+  /**
+   * Writes back dirty pages at the cold end of every instance, once.
+   * @param clean_percent the share of every instance that should be ready for reuse without a write
+   * @param max_pages the maximum number of pages to write
+   * @return the number of page writes started
+   */
+  size_t CleanColdFrames(size_t clean_percent = BGWRITER_CLEAN_PERCENT, size_t max_pages = BGWRITER_MAX_PAGES);
+
+  /**
+   * Starts a thread that calls CleanColdFrames every bgwriter_interval. Does nothing if one is already running.
+   * @param clean_percent the share of every instance that should be ready for reuse without a write
+   * @param max_pages the maximum number of pages to write per round, which bounds the write rate
+   */
+  void StartBackgroundWriter(size_t clean_percent = BGWRITER_CLEAN_PERCENT, size_t max_pages = BGWRITER_MAX_PAGES);
+
+  /** Stops the background writer thread, if it is running. */
+  void StopBackgroundWriter();
+
+  /**
+   * Writes the ids of the resident pages to a file, most recently used first, for WarmUp() to read after a restart.
+   * The file is replaced as a whole, so a crash while dumping leaves the previous dump intact.
+   * @param file_name the dump file
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const std::string &file_name) const;
+
+  /**
+   * Reads the pages listed in a dump file into the buffer pool, as many of the most recently used ones as fit. The
+   * pages are sorted by id and split into ranges that num_threads threads read in parallel, so the reads are mostly
+   * sequential. A missing or damaged dump file loads nothing.
+   * @param file_name the dump file written by DumpResidentPages()
+   * @param num_threads the number of threads reading pages; at least one reads them
+   * @param is_foreign if set, the pages for which it returns true are skipped, e.g. those cached by another pool
+   * @return the number of pages loaded
+   */
+  size_t WarmUp(const std::string &file_name, size_t num_threads = WARM_UP_THREADS,
+                const std::function<bool(page_id_t)> &is_foreign = nullptr);
+
+  /**
+   * Starts a thread that calls DumpResidentPages(file_name) every pool_dump_interval. Does nothing if one is already
+   * running.
+   * @param file_name the dump file
+   */
+  void StartPoolDumper(const std::string &file_name);
+
+  /** Stops the pool dumper thread, if it is running, and writes a last dump. */
+  void StopPoolDumper();
+
+  /** @return a snapshot of the counters of the whole buffer pool */
+  BufferPoolMetrics GetMetrics() const;
+
+  /** @return a snapshot of the counters of every instance, indexed like the instances */
+  std::vector<BufferPoolMetrics> GetInstanceMetrics() const;
+
+  /** @return the counters of the whole buffer pool and of every instance, one line each */
+  std::string GetMetricsReport() const;
+
+  /**
+   * Starts a thread that appends GetMetricsReport() to a file every metrics_report_interval. Does nothing if one is
+   * already running.
+   * @param file_name the report file
+   */
+  void StartMetricsReporter(const std::string &file_name);
+
+  /** Stops the metrics reporter thread, if it is running. */
+  void StopMetricsReporter();
+
+  /**
+   * Creates an access strategy for a sequential scan over this buffer pool.
+   * @param ring_size the number of frames the scan may recycle
+   * @return the strategy, to be passed to FetchPage for every page of the scan
+   */
+  std::unique_ptr<BufferAccessStrategy> GetScanStrategy(size_t ring_size = SCAN_BUFFER_RING_SIZE) const {
+    return std::make_unique<BufferAccessStrategy>(ring_size, instances_.size());
+  }
+
+  /**
+   * Creates a page allocator for one table or index, which keeps its pages contiguous on disk.
+   * @param extent_size the number of contiguous pages reserved at a time
+   * @return the allocator, to be passed to NewPage for every page of the table or index
+   */
+  std::unique_ptr<ExtentAllocator> GetExtentAllocator(size_t extent_size = EXTENT_SIZE) const {
+    return std::make_unique<ExtentAllocator>(disk_manager_, extent_size);
+  }
+
  protected:
+  /** First word of a buffer pool dump file. */
+  static constexpr uint32_t POOL_DUMP_MAGIC = 0x42504431;
+
+  /** @return the number of frames instance instance_index gets out of pool_size frames split num_instances ways */
+  static size_t GetInstanceSize(size_t pool_size, size_t num_instances, size_t instance_index) {
+    return pool_size / num_instances + (instance_index < pool_size % num_instances ? 1 : 0);
+  }
+
+  /** @return the index of the instance responsible for page_id */
+  size_t GetInstanceIndex(page_id_t page_id) const { return static_cast<size_t>(page_id) % instances_.size(); }
+
+  /** Body of the background writer thread. */
+  void RunBackgroundWriter(size_t clean_percent, size_t max_pages);
+
+  /** Body of the pool dumper thread. */
+  void RunPoolDumper(const std::string &file_name);
+
+  /** Body of the metrics reporter thread. */
+  void RunMetricsReporter(const std::string &file_name);
+
+
+  /** @return the instance responsible for page_id */
+  BufferPoolManagerInstance *GetInstance(page_id_t page_id) const {
+    return instances_[GetInstanceIndex(page_id)].get();
+  }
+
   /** Number of pages in the buffer pool. */
-  size_t pool_size_;
-  /** Array of buffer pool pages. */
-  std::unique_ptr<std::vector<Page>> pages_;
+  std::atomic<size_t> pool_size_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUReplacer> replacer_;
-  /** List of free pages. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  mutable std::mutex latch_;
+  /** The partitions of the buffer pool, indexed by page id modulo their count. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** True while the background writer should keep running. */
+  std::atomic<bool> enable_background_writer_{false};
+  std::unique_ptr<std::thread> background_writer_;
+  /** Lets StopBackgroundWriter() wake the background writer up early. */
+  std::mutex background_writer_latch_;
+  std::condition_variable background_writer_cv_;
+  /** True while the pool dumper should keep running. */
+  std::atomic<bool> enable_pool_dumper_{false};
+  std::unique_ptr<std::thread> pool_dumper_;
+  std::string pool_dump_file_;
+  /** Lets StopPoolDumper() wake the pool dumper up early. */
+  std::mutex pool_dumper_latch_;
+  std::condition_variable pool_dumper_cv_;
+  /** True while the metrics reporter should keep running. */
+  std::atomic<bool> enable_metrics_reporter_{false};
+  std::unique_ptr<std::thread> metrics_reporter_;
+  /** Lets StopMetricsReporter() wake the metrics reporter up early. */
+  std::mutex metrics_reporter_latch_;
+  std::condition_variable metrics_reporter_cv_;
+  /** Events that no instance sees, such as a NewPage() turned away because every frame is pinned. */
+  BufferPoolCounters counters_;
+  /** Serializes resizes. */
+  std::mutex resize_latch_;
 };
 }  // namespace bustub
@@ -0,0 +1,308 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_instance.h
+//
+// Identification: src/include/buffer/buffer_pool_manager_instance.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "common/macros.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * BufferPoolManagerInstance is a single partition of the buffer pool. It owns a page table, a free list and a
+ * replacer for a fixed slice of frames, all protected by one latch. BufferPoolManager routes every page id to
+ * exactly one instance, so instances never share state and never contend with each other.
+ *
+ * Hits do not take the latch. The page table can be read without a latch and pin counts are atomic, so fetching a
+ * resident page costs a lookup and a compare-and-swap on its pin count. Unpinning takes no latch either, unless the
+ * frame has to be handed back to the replacer. Whenever the instance takes a frame away from its page (to evict it,
+ * to load a page into it, or to free it), it first swaps the pin count from 0 to FRAME_BUSY, which lock-free pins
+ * cannot get past.
+ *
+ * The instance can grow and shrink while it runs. Its frames live in a FrameArena, so they never move: growing adds
+ * frames to the free list, and shrinking drains the frames at the end, evicting their pages as soon as nobody has
+ * them pinned, and gives their memory back.
+ */
+class BufferPoolManagerInstance {
+ public:
+  /**
+   * Creates a new BufferPoolManagerInstance.
+   * @param pool_size the number of frames managed by this instance
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   */
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                            ReplacerType replacer_type = ReplacerType::LRU);
+
+  /** Waits for the prefetch reads and eviction writes still in flight. */
+  ~BufferPoolManagerInstance();
+
+  DISALLOW_COPY_AND_MOVE(BufferPoolManagerInstance);
+
+  /**
+   * Fetch the requested page from this instance.
+   * @param page_id id of page to be fetched
+   * @param ring if not nullptr, a page that has to be read from disk goes into a frame of this ring
+   * @return the requested page, nullptr if every frame is pinned
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr);
+
+  /**
+   * Find the requested page for an optimistic read, without pinning or latching it. The frame stays valid memory,
+   * but may be reused for another page at any time; validate the read with Page::ValidateOptimisticRead().
+   * @param page_id id of page to be read
+   * @param[out] version the version to validate the read against
+   * @return the page, nullptr if it is not resident or is being changed right now
+   */
+  Page *FetchPageOptimistic(page_id_t page_id, uint64_t *version);
+
+  /**
+   * Pin the requested page if it is resident and not busy, through the lock-free path of FetchPage() only.
+   * @param page_id id of page to be pinned
+   * @return the pinned page, nullptr otherwise
+   */
+  Page *FetchResidentPage(page_id_t page_id);
+
+  /**
+   * Unpin the target page.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Places a freshly allocated page in this instance.
+   * @param page_id id of the page, already allocated on disk by the caller
+   * @return nullptr if every frame is pinned, otherwise pointer to the new page
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Deletes a page from this instance.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Pins every dirty page of this instance and clears its dirty flag, so that the caller can write the pages without
+   * the latch. Whoever changes a page meanwhile marks it dirty again. The caller unpins the pages once they are written.
+   * @return the pinned pages
+   */
+  std::vector<Page *> PinDirtyPages();
+
+  /**
+   * Reserves a frame for a page that is about to be prefetched. The frame stays busy and the page stays marked as
+   * being read until CompletePrefetch(), so the caller can read the page into it without holding the latch. Anyone
+   * fetching the page in the meantime waits for the read to finish.
+   * @param page_id id of page to be prefetched
+   * @param ring if not nullptr, the page goes into a frame of this ring
+   * @return the frame to read the page into, nullptr if the page is already resident or every frame is pinned
+   */
+  Page *BeginPrefetch(page_id_t page_id, BufferRing *ring = nullptr);
+
+  /**
+   * Publishes a page read after BeginPrefetch() and hands its frame to the replacer. If the read failed, the page is
+   * dropped and its frame freed instead.
+   * @param page_id id of the prefetched page
+   * @param ok whether the read succeeded
+   */
+  void CompletePrefetch(page_id_t page_id, bool ok);
+
+  /**
+   * Writes back dirty pages at the cold end of the replacer, so that evicting them later needs no I/O. The writes are
+   * asynchronous and the latch is not held while they run; a page stays busy until its write is done.
+   * @param num_clean_frames the number of frames, counting free ones, that should be ready for reuse without a write
+   * @param max_writes the maximum number of pages to write
+   * @return the number of page writes started
+   */
+  size_t CleanColdFrames(size_t num_clean_frames, size_t max_writes);
+
+  /** @return true if no frame of this instance can be used for a new page */
+  bool CheckAllPinned() const;
+
+  /**
+   * @return the ids of the pages resident in this instance, most recently used first: pinned pages, then the frames of
+   * the replacer from its hot end to its cold end
+   */
+  std::vector<page_id_t> GetResidentPages() const;
+
+  /** @return a snapshot of the counters of this instance */
+  BufferPoolMetrics GetMetrics() const { return counters_.Snapshot(); }
+
+  /**
+   * Changes the number of frames of this instance. Growing always succeeds. Shrinking evicts the pages held by the
+   * frames past new_size, waiting for them to be unpinned; if one stays pinned for longer than timeout, the instance
+   * keeps its size.
+   * @param new_size the new number of frames, at least one
+   * @param timeout how long to wait for pinned pages when shrinking
+   * @return true if the instance has new_size frames now
+   */
+  bool Resize(size_t new_size, std::chrono::milliseconds timeout);
+
+  /** @return number of frames in this instance */
+  size_t GetPoolSize() const { return pool_size_; }
+
+  /**
+   * @param frame_id id of a frame, less than GetPoolSize()
+   * @return the frame
+   */
+  Page *GetFrame(frame_id_t frame_id) const { return frames_.GetFrame(frame_id); }
+
+ private:
+  /** Pin count of a frame that lock-free pins must keep off: free, being loaded, being evicted or being cleaned. */
+  static constexpr int FRAME_BUSY = -1;
+
+  /**
+   * Pins a frame found in the page table, without the latch.
+   * @return false if the frame is busy or no longer holds page_id
+   */
+  bool TryPin(frame_id_t frame_id, page_id_t page_id);
+
+  /** Drops a pin on a frame, handing the frame back to the replacer if it was the last pin and the replacer lost it. */
+  void UnpinFrame(frame_id_t frame_id);
+
+  /** Takes latch_ on behalf of a foreground request, counting the time spent waiting for it. */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /** @return the frame with id frame_id */
+  Page &Frame(frame_id_t frame_id) const { return *frames_.GetFrame(frame_id); }
+
+  /** @return the current page table; a lock-free reader may still be looking at an older one */
+  PageTable &Table() const { return *page_table_.load(std::memory_order_acquire); }
+
+  /** Takes a frame away from lock-free pins, if nobody has it pinned. Caller must hold latch_. */
+  bool TryMakeBusy(frame_id_t frame_id) {
+    int unpinned = 0;
+    return Frame(frame_id).pin_count_.compare_exchange_strong(unpinned, FRAME_BUSY);
+  }
+
+  /** Puts an unpinned frame at the most recently used end of the replacer. Caller must hold latch_. */
+  void MakeEvictable(frame_id_t frame_id) {
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    Frame(frame_id).in_replacer_ = true;
+  }
+
+  /** @return true if a shrink is draining the frame, so it must not be handed out. Caller must hold latch_. */
+  bool IsRetiring(frame_id_t frame_id) const { return static_cast<size_t>(frame_id) >= target_size_; }
+
+  /** Set aside a busy, retiring frame that holds no page any more. Caller must hold latch_. */
+  void RetireFrame(frame_id_t frame_id);
+
+  /** Add frames until there are new_size of them. Caller must hold latch_. */
+  void Grow(size_t new_size);
+
+  /** Retire every retiring frame that is free or can be evicted right now. Caller must hold latch_. */
+  void DrainRetiringFrames();
+
+  /** Record a fetch of a frame's page by someone who is not recycling a ring of frames. */
+  void MarkSharedUse(frame_id_t frame_id, BufferRing *ring) {
+    // Only the first such fetch writes to the frame, so that hot pages do not bounce a cache line between cores.
+    if (ring == nullptr && !Frame(frame_id).shared_use_.load(std::memory_order_relaxed)) {
+      Frame(frame_id).shared_use_.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  /** Drop the page of a busy frame without writing it back, and free the frame. Caller must hold latch_. */
+  void DropFrame(frame_id_t frame_id);
+
+  /**
+   * Reset a busy frame so that it holds page_id; the caller publishes it, which ends the change of the page data that
+   * began when the frame was freed or evicted. Caller must hold latch_.
+   */
+  void ResetPage(frame_id_t frame_id, page_id_t page_id);
+
+  /** Obtain a free frame, evicting a victim if the free list is empty. The frame is busy. Caller must hold latch_. */
+  bool ObtainFreeFrame(frame_id_t *frame_id);
+
+  /**
+   * Recycle the oldest frame of a full ring, if it still holds the page the scan read into it and nobody has it
+   * pinned. The frame is busy. Caller must hold latch_.
+   */
+  bool ObtainRingFrame(BufferRing *ring, frame_id_t *frame_id);
+
+  /**
+   * Drop the page held by a busy frame from the page table. A dirty page is copied and written back in the
+   * background, so the frame can be reused right away. Caller must hold latch_.
+   */
+  void EvictFrame(frame_id_t frame_id);
+
+  /** @return true if a prefetch read or an eviction write of page_id is in flight. Caller must hold latch_. */
+  bool HasPendingIO(page_id_t page_id) const {
+    return pending_reads_.count(page_id) != 0 || pending_writes_.count(page_id) != 0;
+  }
+
+  /** Number of frames in this instance. Written under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Frames from this one on are being drained by a shrink; equals pool_size_ otherwise. */
+  size_t target_size_;
+  /** The frames of this instance. Frames past pool_size_ are busy and hold no page. */
+  FrameArena frames_;
+  /** Number of frames of the arena that have been set up as busy and empty. */
+  size_t num_prepared_frames_{0};
+  /** Retiring frames that a shrink has drained so far. */
+  std::unordered_set<frame_id_t> retired_frames_;
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_;
+  /** Pointer to the log manager. */
+  LogManager *log_manager_;
+  /**
+   * Page table for keeping track of the pages resident in this instance. Readable without latch_. Growing the
+   * instance may replace it with a larger one; the old ones are kept, since a lock-free reader may still use them.
+   */
+  std::atomic<PageTable *> page_table_;
+  std::vector<std::unique_ptr<PageTable>> page_tables_;
+  /** Replacer to find unpinned frames for replacement. It may hold frames that were pinned without the latch. */
+  std::unique_ptr<Replacer> replacer_;
+  /** List of free frames. */
+  std::list<frame_id_t> free_list_;
+  /** Pages whose frame is reserved but whose prefetch read has not completed yet. */
+  std::unordered_set<page_id_t> pending_reads_;
+  /** Evicted pages whose write-back has not completed yet; reading them from disk has to wait. */
+  std::unordered_set<page_id_t> pending_writes_;
+  /** Hits, misses, evictions and the like. */
+  BufferPoolCounters counters_;
+  /** Signalled whenever a prefetch read or an eviction write completes. */
+  std::condition_variable io_done_;
+  /** Protects page_table_, replacer_, free_list_, the pending sets, resizing and the book-keeping fields of frames. */
+  mutable std::mutex latch_;
+};
+
+}  // namespace bustub
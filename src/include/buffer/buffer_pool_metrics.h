@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The events a buffer pool counts. */
+enum class BufferPoolCounter : size_t {
+  HITS,                // fetches that found the page resident
+  MISSES,              // fetches that read the page from disk
+  EVICTIONS,           // pages evicted to make room for another one
+  DIRTY_EVICTIONS,     // evicted pages that had to be written back
+  NO_FREE_FRAME,       // fetches and new pages that failed because every frame was pinned
+  FLUSHES,             // pages written by FlushPage() and FlushAllPages(); the pool counts the latter itself
+  FLUSH_TIME_US,       // time spent writing those pages
+  LATCH_WAITS,         // times a foreground request found the instance latch taken
+  LATCH_WAIT_TIME_US,  // time spent waiting for it
+  NUM_COUNTERS
+};
+
+/** A snapshot of the counters of a buffer pool, or of one of its instances. */
+struct BufferPoolMetrics {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+  uint64_t dirty_evictions{0};
+  uint64_t no_free_frame{0};
+  uint64_t flushes{0};
+  uint64_t flush_time_us{0};
+  uint64_t latch_waits{0};
+  uint64_t latch_wait_time_us{0};
+
+  /** @return the share of fetches that found their page resident, 0 if there were none */
+  double HitRatio() const { return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses); }
+
+  /** Adds the counters of that to these ones. */
+  BufferPoolMetrics &operator+=(const BufferPoolMetrics &that);
+
+  /** @return the counters as one line of key=value pairs */
+  std::string ToString() const;
+};
+
+/**
+ * BufferPoolCounters counts the events of a buffer pool instance. Hits are counted on the lock-free fetch path, so a
+ * single atomic counter would make every core fight over one cache line. Instead, every thread adds to one of several
+ * cache-line sized stripes, and Snapshot() sums them up. The counts are relaxed: a snapshot taken while the pool is
+ * busy is a consistent enough picture for sizing pools, not an exact one.
+ */
+class BufferPoolCounters {
+ public:
+  /** Adds value to a counter. */
+  void Add(BufferPoolCounter counter, uint64_t value = 1) {
+    stripes_[StripeIndex()].counts_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /** Adds the microseconds elapsed since start to a counter. */
+  void AddTimeSince(BufferPoolCounter counter, std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    Add(counter, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  }
+
+  /** @return the sums of all counters */
+  BufferPoolMetrics Snapshot() const;
+
+ private:
+  static constexpr size_t NUM_STRIPES = 16;
+  static constexpr size_t NUM_COUNTERS = static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS);
+
+  struct alignas(CACHE_LINE_SIZE) Stripe {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> counts_{};
+  };
+
+  /** @return the stripe of the calling thread, fixed for the lifetime of the thread */
+  static size_t StripeIndex();
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the frames of a buffer pool instance. Frames are allocated in chunks that double in size, and
+ * never move or go away while the arena exists. A Page * therefore stays valid while the pool grows and shrinks,
+ * and a frame can be looked up by its id without a latch.
+ *
+ * The data of the frames is kept apart from their Page descriptors, in page-aligned anonymous memory that the
+ * operating system only backs once a frame is used. Release() hands the memory of an unused frame back to it.
+ * Chunks of at least HUGE_PAGE_SIZE bytes are backed by huge pages, which cuts TLB misses on large pools: reserved
+ * huge pages if the system has enough of them, otherwise memory aligned to HUGE_PAGE_SIZE that is marked for
+ * transparent huge pages. The descriptors sit in arrays of their own and are cache-line aligned, so that pinning one
+ * frame does not bounce the cache line of another one, or of the page data.
+ */
+class FrameArena {
+ public:
+  /** @param first_chunk_size the number of frames in the first chunk; every later chunk is twice the previous one */
+  explicit FrameArena(size_t first_chunk_size);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /**
+   * Looks up a frame without any latch.
+   * @param frame_id id of the frame, less than Capacity()
+   * @return the frame
+   */
+  Page *GetFrame(frame_id_t frame_id) const {
+    const size_t chunk = ChunkOf(frame_id);
+    return chunks_[chunk].load(std::memory_order_acquire) + (frame_id - ChunkStart(chunk));
+  }
+
+  /** @return the number of frames allocated so far */
+  size_t Capacity() const { return ChunkStart(num_chunks_); }
+
+  /**
+   * Allocates chunks until there are at least num_frames frames. Calls must be serialized, but may run concurrently
+   * with GetFrame() on the frames that exist already.
+   * @param num_frames the number of frames needed
+   */
+  void Reserve(size_t num_frames);
+
+  /**
+   * Gives the memory holding the data of a frame back to the operating system. The data reads as zeros afterwards,
+   * and the memory is backed again once the frame is written to.
+   * @param frame_id id of a frame nobody uses
+   */
+  void Release(frame_id_t frame_id);
+
+  /** @return the number of chunks backed by reserved huge pages */
+  size_t NumHugeTlbChunks() const;
+
+ private:
+  static constexpr size_t MAX_CHUNKS = 32;
+
+  /** @return the chunk holding frame_id: chunk c holds first_chunk_size_ * 2^c frames */
+  size_t ChunkOf(frame_id_t frame_id) const {
+    return 63 - __builtin_clzll(static_cast<size_t>(frame_id) / first_chunk_size_ + 1);
+  }
+
+  /** @return the id of the first frame of a chunk */
+  size_t ChunkStart(size_t chunk) const { return first_chunk_size_ * ((size_t{1} << chunk) - 1); }
+
+  const size_t first_chunk_size_;
+  /** Number of chunks allocated so far. */
+  size_t num_chunks_{0};
+  /** Page descriptors of every chunk, published once the chunk is ready. */
+  std::array<std::atomic<Page *>, MAX_CHUNKS> chunks_{};
+  /** Data of every chunk, one page per frame. */
+  std::array<char *, MAX_CHUNKS> data_{};
+  /** Number of bytes mapped for the data of every chunk, rounded up to whole huge pages if they back the chunk. */
+  std::array<size_t, MAX_CHUNKS> data_size_{};
+  /** True for the chunks backed by reserved huge pages, which cannot give back single frames. */
+  std::array<bool, MAX_CHUNKS> huge_tlb_{};
+};
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward K-distance of a frame is the time elapsed since its K-th most recent access. The victim is the
+ * evictable frame with the largest backward K-distance. Frames with fewer than K recorded accesses have an infinite
+ * distance and are evicted first, oldest first access first, so a single sequential scan cannot push out pages that
+ * have been referenced repeatedly.
+ *
+ * Every Pin() counts as an access. Unpin() only makes a frame evictable; it records an access only for a frame that
+ * has no history yet.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses remembered for every frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void Resize(size_t num_pages) override;
+
+  std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+ private:
+  /** Eviction order: frames with fewer than k accesses first, then by their oldest remembered access. */
+  using EvictionKey = std::pair<bool, uint64_t>;
+
+  /** Appends the current time to the history of frame_id, forgetting everything older than the last k accesses. */
+  void RecordAccess(frame_id_t frame_id);
+
+  /** @return the eviction order key of frame_id, which must have a non-empty history */
+  EvictionKey KeyOf(frame_id_t frame_id) const;
+
+  size_t num_pages_;
+  const size_t k_;
+  /** Logical clock, advanced on every recorded access. */
+  uint64_t current_timestamp_{0};
+  /** Timestamps of the last (at most) k accesses of every frame, oldest first. */
+  std::vector<std::deque<uint64_t>> history_;
+  /** True for frames that are currently in evictable_. */
+  std::vector<bool> is_evictable_;
+  /** Evictable frames, ordered by decreasing backward K-distance. */
+  std::set<std::pair<EvictionKey, frame_id_t>> evictable_;
+};
+
+}  // namespace bustub
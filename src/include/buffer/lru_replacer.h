@@ -49,8 +49,12 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  void Resize(size_t num_pages) override;
+
+  std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
  private:
-  const size_t num_pages_;
+  size_t num_pages_;
   std::list<frame_id_t> pages_;
   std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> page_table_;
 };
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the pages resident in a buffer pool instance to their frames. It is an open-addressing
+ * hash table with linear probing whose slots are single atomic words, so lookups take no latch at all.
+ *
+ * Writers (Insert and Erase) must be serialized by the caller, which holds the instance latch anyway. Erase closes
+ * the gap it leaves by shifting later entries back (no tombstones), so a concurrent lookup may miss an entry that is
+ * being shifted. Lock-free readers must therefore treat a miss as "not sure" and repeat the lookup under the latch;
+ * a hit may also be stale by the time it is used, and has to be validated against the frame.
+ */
+class PageTable {
+ public:
+  /** @param max_entries the maximum number of entries, i.e. the number of frames */
+  explicit PageTable(size_t max_entries);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Looks up a page without any latch.
+   * @param page_id id of the page
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const {
+    for (size_t slot = Home(page_id);; slot = (slot + 1) & mask_) {
+      const uint64_t entry = slots_[slot].load(std::memory_order_acquire);
+      if (entry == EMPTY) {
+        return false;
+      }
+      if (PageIdOf(entry) == page_id) {
+        *frame_id = FrameIdOf(entry);
+        return true;
+      }
+    }
+  }
+
+  /** Adds an entry for a page that is not in the table yet. Writers must be serialized. */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes the entry of a page. Writers must be serialized.
+   * @return true if the page was in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  /** @return the number of entries */
+  size_t Size() const { return size_; }
+
+  /** @return the maximum number of entries, as passed to the constructor */
+  size_t MaxEntries() const { return max_entries_; }
+
+  /** Calls callback(page_id, frame_id) for every entry. Writers must be serialized with this. */
+  template <class Callback>
+  void ForEach(Callback callback) const {
+    for (size_t slot = 0; slot <= mask_; ++slot) {
+      const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+      if (entry != EMPTY) {
+        callback(PageIdOf(entry), FrameIdOf(entry));
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+  static uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t PageIdOf(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static frame_id_t FrameIdOf(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xffffffff); }
+
+  /** @return the slot a page hashes to. Page ids are dense, so they are scattered with a multiplicative hash. */
+  size_t Home(page_id_t page_id) const {
+    return static_cast<size_t>((static_cast<uint64_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  /** The slots; at most half of them are used, which keeps probe sequences short. */
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  size_t mask_;
+  int shift_;
+  size_t size_{0};
+  size_t max_entries_;
+};
+
+}  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManager can be built with. */
+enum class ReplacerType { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -45,6 +50,20 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Changes the number of frames the replacer can be required to store, as the buffer pool grows or shrinks. Frames
+   * past the new number must not be in the replacer.
+   * @param num_pages the new number of frames
+   */
+  virtual void Resize(size_t num_pages) = 0;
+
+  /**
+   * Looks at the cold end of the replacer without changing it.
+   * @param max_frames the maximum number of frames to return
+   * @return the frames that are going to be victimized next, coldest first
+   */
+  virtual std::vector<frame_id_t> PeekVictims(size_t max_frames) = 0;
 };
 
 }  // namespace bustub
@@ -73,18 +73,26 @@ class Catalog {
    * @param txn the transaction in which the table is being created
    * @param table_name the name of the new table
    * @param schema the schema of the new table
+   * @param bpm the buffer pool that holds the pages of the table, nullptr for the buffer pool of the catalog
    * @return a pointer to the metadata of the new table
    */
-  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
+  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                             BufferPoolManager *bpm = nullptr) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
-    return nullptr;
+    auto table = std::make_unique<TableHeap>(bpm != nullptr ? bpm : bpm_, lock_manager_, log_manager_, txn);
+    const table_oid_t table_oid = next_table_oid_++;
+    auto metadata = std::make_unique<TableMetadata>(schema, table_name, std::move(table), table_oid);
+    TableMetadata *table_metadata = metadata.get();
+    tables_.emplace(table_oid, std::move(metadata));
+    names_.emplace(table_name, table_oid);
+    return table_metadata;
   }
 
-  /** @return table metadata by name */
-  TableMetadata *GetTable(const std::string &table_name) { return nullptr; }
+  /** @return table metadata by name; throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(const std::string &table_name) { return GetTable(names_.at(table_name)); }
 
-  /** @return table metadata by oid */
-  TableMetadata *GetTable(table_oid_t table_oid) { return nullptr; }
+  /** @return table metadata by oid; throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(table_oid_t table_oid) { return tables_.at(table_oid).get(); }
 
   /**
    * Create a new index, populate existing data of the table and return its metadata.
@@ -95,25 +103,62 @@ class Catalog {
    * @param key_schema the schema of the key
    * @param key_attrs key attributes
    * @param keysize size of the key
+   * @param bpm the buffer pool that holds the pages of the index, nullptr for the buffer pool of the catalog. The
+   * header page, where the index records its root, always goes through the buffer pool of the catalog.
    * @return a pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         size_t keysize) {
-    return nullptr;
+                         size_t keysize, BufferPoolManager *bpm = nullptr) {
+    BUSTUB_ASSERT(index_names_[table_name].count(index_name) == 0, "Index names should be unique per table!");
+    auto *metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs);
+    BufferPoolManager *index_bpm = bpm != nullptr ? bpm : bpm_;
+    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(metadata, index_bpm, bpm_);
+
+    // Build the index from all rows at once rather than inserting them one by one.
+    TableHeap *table = GetTable(table_name)->table_.get();
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      KeyType index_key;
+      index_key.SetFromKey(it->KeyFromTuple(schema, key_schema, key_attrs));
+      entries.emplace_back(index_key, it->GetRid());
+    }
+    index->BulkLoad(&entries);
+
+    const index_oid_t index_oid = next_index_oid_++;
+    auto index_info = std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name,
+                                                  keysize);
+    IndexInfo *info = index_info.get();
+    indexes_.emplace(index_oid, std::move(index_info));
+    index_names_[table_name].emplace(index_name, index_oid);
+    return info;
   }
 
-  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) { return nullptr; }
-
-  IndexInfo *GetIndex(index_oid_t index_oid) { return nullptr; }
+  /** @return index metadata by index and table name; throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    return GetIndex(index_names_.at(table_name).at(index_name));
+  }
 
-  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) { return std::vector<IndexInfo *>(); }
+  /** @return index metadata by oid; throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(index_oid_t index_oid) { return indexes_.at(index_oid).get(); }
+
+  /** @return the metadata of all indexes on the table */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    std::vector<IndexInfo *> table_indexes;
+    auto it = index_names_.find(table_name);
+    if (it != index_names_.end()) {
+      for (const auto &[index_name, index_oid] : it->second) {
+        table_indexes.push_back(GetIndex(index_oid));
+      }
+    }
+    return table_indexes;
+  }
 
  private:
-  [[maybe_unused]] BufferPoolManager *bpm_;
-  [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  BufferPoolManager *bpm_;
+  LockManager *lock_manager_;
+  LogManager *log_manager_;
 
   /** tables_ : table identifiers -> table metadata. Note that tables_ owns all table metadata. */
   std::unordered_map<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -23,7 +26,16 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * Opens a database.
+   * @param db_file_name the database file
+   * @param warm_up if true, the pages that were resident when the database was last used with warm_up are read back
+   * into the buffer pool before the constructor returns, and the resident pages are dumped to <db>.bpdump for the next
+   * start while the instance runs; if false, no dump is read or written
+   * @param background_writer if true, every buffer pool runs a background writer that writes back dirty pages before
+   * they are evicted
+   */
+  explicit BustubInstance(const std::string &db_file_name, bool warm_up = false, bool background_writer = false) {
     enable_logging = false;
 
     // storage related
@@ -32,7 +44,11 @@ class BustubInstance {
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
+    db_base_name_ = db_file_name.substr(0, db_file_name.rfind('.'));
+    warm_up_ = warm_up;
+    background_writer_ = background_writer;
     buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    StartPool(buffer_pool_manager_, db_base_name_ + ".bpdump");
 
     // txn related
     lock_manager_ = new LockManager();
@@ -43,6 +59,11 @@ class BustubInstance {
   }
 
   ~BustubInstance() {
+    for (auto &[name, pool] : buffer_pools_) {
+      StopPool(pool.get());
+    }
+    buffer_pools_.clear();
+    StopPool(buffer_pool_manager_);
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
@@ -54,12 +75,82 @@ class BustubInstance {
     delete disk_manager_;
   }
 
+  /**
+   * Creates a buffer pool of its own for one class of pages, e.g. the indexes, the table heaps or temporary pages, so
+   * that they do not evict each other. All pools share the database file; a page must only ever be cached by one of
+   * them, so every page belongs to the pool it was created in. Scans only read ahead along the page list of their own
+   * table or index, and warming up a pool skips the pages another pool holds already, in case the dumps of two pools
+   * were taken at different times. If the instance was opened with warm_up, the pool warms up from and dumps its
+   * resident pages to <db>.<name>.bpdump like the default pool does.
+   * @param name the name of the pool, which must not be taken yet
+   * @param pool_size the number of frames of the pool
+   * @return the new pool, owned by the instance
+   */
+  BufferPoolManager *CreateBufferPool(const std::string &name, size_t pool_size) {
+    BUSTUB_ASSERT(name != DEFAULT_BUFFER_POOL && buffer_pools_.count(name) == 0, "Buffer pool names should be unique!");
+    auto pool = std::make_unique<BufferPoolManager>(pool_size, disk_manager_, log_manager_);
+    StartPool(pool.get(), db_base_name_ + "." + name + ".bpdump");
+    return buffer_pools_.emplace(name, std::move(pool)).first->second.get();
+  }
+
+  /** @return the buffer pool of that name, buffer_pool_manager_ for DEFAULT_BUFFER_POOL, nullptr if there is none */
+  BufferPoolManager *GetBufferPool(const std::string &name) const {
+    if (name == DEFAULT_BUFFER_POOL) {
+      return buffer_pool_manager_;
+    }
+    auto it = buffer_pools_.find(name);
+    return it != buffer_pools_.end() ? it->second.get() : nullptr;
+  }
+
+  /** The name of buffer_pool_manager_, which holds the header page and every page not assigned to another pool. */
+  static constexpr const char *DEFAULT_BUFFER_POOL = "default";
+
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+
+ private:
+  void StartPool(BufferPoolManager *pool, const std::string &pool_dump_file) {
+    if (warm_up_) {
+      pool->WarmUp(pool_dump_file, WARM_UP_THREADS,
+                   [this, pool](page_id_t page_id) { return IsCachedElsewhere(pool, page_id); });
+      pool->StartPoolDumper(pool_dump_file);
+    }
+    if (background_writer_) {
+      pool->StartBackgroundWriter();
+    }
+  }
+
+  /** @return true if a pool other than pool holds page_id */
+  bool IsCachedElsewhere(BufferPoolManager *pool, page_id_t page_id) const {
+    auto is_cached = [pool, page_id](BufferPoolManager *other) {
+      Page *page = other != pool ? other->FetchResidentPage(page_id) : nullptr;
+      return page != nullptr && other->UnpinPage(page_id, false);
+    };
+    if (is_cached(buffer_pool_manager_)) {
+      return true;
+    }
+    for (auto &[name, other] : buffer_pools_) {
+      if (is_cached(other.get())) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void StopPool(BufferPoolManager *pool) {
+    pool->StopPoolDumper();
+    pool->StopBackgroundWriter();
+  }
+
+  std::string db_base_name_;
+  bool warm_up_;
+  bool background_writer_;
+  /** The buffer pools created with CreateBufferPool(), by name. */
+  std::unordered_map<std::string, std::unique_ptr<BufferPoolManager>> buffer_pools_;
 };
 
 }  // namespace bustub
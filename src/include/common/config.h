@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,6 +28,18 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background writer of the buffer pool cleans cold frames every BGWRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bgwriter_interval;
+
+/** The buffer pool dumper writes the ids of the resident pages to its file every POOL_DUMP_INTERVAL milliseconds. */
+extern std::chrono::milliseconds pool_dump_interval;
+
+/** The metrics reporter of the buffer pool appends its counters to its file every METRICS_REPORT_INTERVAL ms. */
+extern std::chrono::milliseconds metrics_report_interval;
+
+/** Shrinking the buffer pool gives up if pinned pages keep a frame busy for RESIZE_DRAIN_TIMEOUT milliseconds. */
+extern std::chrono::milliseconds resize_drain_timeout;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
@@ -35,6 +48,19 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;          // accesses remembered per frame by the LRU-K replacer
+static constexpr int SCAN_BUFFER_RING_SIZE = 32;   // frames a sequential scan recycles instead of using the whole pool
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 128;   // requests the asynchronous I/O engine keeps in flight
+static constexpr int ASYNC_IO_THREADS = 4;         // worker threads of the thread-pool I/O engine
+static constexpr int PREFETCH_DEPTH = 8;           // pages a sequential scan keeps in flight ahead of itself
+static constexpr int EXTENT_SIZE = 64;             // contiguous pages a table or an index reserves at a time
+static constexpr int BGWRITER_CLEAN_PERCENT = 20;  // share of each pool instance the background writer keeps clean
+static constexpr int BGWRITER_MAX_PAGES = 64;      // pages the background writer writes per round at most
+static constexpr int WARM_UP_THREADS = 4;          // threads that load the pages of a buffer pool dump at startup
+static constexpr int OPTIMISTIC_DESCENT_ATTEMPTS = 4;      // optimistic B+ tree descents before latching the way down
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;       // share of each page a B+ tree bulk load fills
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;  // size of the huge pages backing large buffer pool chunks
+static constexpr size_t CACHE_LINE_SIZE = 64;              // frame descriptors are aligned to cache lines
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -12,25 +12,36 @@
 
 #pragma once
 
-#include <climits>
+#include <atomic>
 #include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
 
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch. The whole latch state is one atomic word: the number of readers holding the latch, the number
+ * of writers waiting for it, and whether a writer holds it. Taking or releasing an uncontended latch is a single
+ * atomic operation.
+ *
+ * A thread that has to wait spins for a little while, since latches on pages and tree nodes are held briefly, and
+ * then parks until a release wakes it up. Releases only touch the parking mutex if someone is parked.
+ *
+ * Waiting writers keep new readers out, so a steady stream of readers cannot starve a writer.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
+  static constexpr uint64_t WRITER = uint64_t{1} << 63;
+  static constexpr uint64_t WAITING_WRITER = uint64_t{1} << 32;
+  static constexpr uint64_t WAITING_WRITERS_MASK = (WRITER - 1) & ~(WAITING_WRITER - 1);
+  static constexpr uint64_t READERS_MASK = WAITING_WRITER - 1;
+  /** Number of failed attempts to take the latch before a thread parks. */
+  static constexpr int SPIN_LIMIT = 64;
 
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,59 +49,104 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    uint64_t state = 0;
+    if (state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire)) {
+      return;
     }
+    // Announce the writer, so that no more readers get in, and wait for the ones inside to leave.
+    state_.fetch_add(WAITING_WRITER, std::memory_order_relaxed);
+    Acquire([this] {
+      uint64_t state = state_.load(std::memory_order_relaxed);
+      while ((state & (WRITER | READERS_MASK)) == 0) {
+        if (state_.compare_exchange_weak(state, state - WAITING_WRITER + WRITER, std::memory_order_acquire)) {
+          return true;
+        }
+      }
+      return false;
+    });
   }
 
   /**
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    state_.fetch_sub(WRITER, std::memory_order_release);
+    WakeParked();
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
-    }
-    reader_count_++;
+    Acquire([this] {
+      uint64_t state = state_.load(std::memory_order_relaxed);
+      while ((state & (WRITER | WAITING_WRITERS_MASK)) == 0) {
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return true;
+        }
+      }
+      return false;
+    });
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    const uint64_t state = state_.fetch_sub(1, std::memory_order_release);
+    // Only the last reader out can let a waiting writer in.
+    if ((state & READERS_MASK) == 1 && (state & WAITING_WRITERS_MASK) != 0) {
+      WakeParked();
     }
   }
 
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  /** Tell the CPU that we are spinning, so that it can save power and let a sibling hyperthread run. */
+  static void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  /**
+   * Call try_acquire until it succeeds: spin first, then park between attempts. A parked thread is only woken up by a
+   * release, so try_acquire must only fail while someone holds or waits for the latch; a compare-and-swap that fails
+   * spuriously or on a concurrent change is retried as long as the latch looks free.
+   */
+  template <class TryAcquire>
+  void Acquire(TryAcquire try_acquire) {
+    for (int i = 0; i < SPIN_LIMIT; ++i) {
+      if (try_acquire()) {
+        return;
+      }
+      CpuRelax();
+    }
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    // Announce the parked thread before the last attempt: either the attempt sees a release, or the release sees us.
+    parked_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!try_acquire()) {
+      park_cv_.wait(lock);
+    }
+    parked_.fetch_sub(1);
+  }
+
+  /** Wake up the parked threads, if there are any, so that they try again. */
+  void WakeParked() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load() > 0) {
+      std::lock_guard<std::mutex> guard(park_mutex_);
+      park_cv_.notify_all();
+    }
+  }
+
+  std::atomic<uint64_t> state_{0};
+  /** Number of threads parked on park_cv_. */
+  std::atomic<uint32_t> parked_{0};
+  std::mutex park_mutex_;
+  std::condition_variable park_cv_;
 };
 
 }  // namespace bustub
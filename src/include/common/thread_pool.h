@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool.h
+//
+// Identification: src/include/common/thread_pool.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A fixed set of worker threads running tasks in submission order. Used for background I/O, where tasks block on
+ * the disk rather than on the CPU.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Starts the worker threads.
+   * @param num_threads the number of worker threads, at least one
+   */
+  explicit ThreadPool(size_t num_threads) {
+    BUSTUB_ASSERT(num_threads > 0, "A thread pool needs at least one thread.");
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  /**
+   * Runs every task that has already been submitted, then stops the worker threads.
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(ThreadPool);
+
+  /**
+   * Queues a task for one of the worker threads.
+   * @param task the task to run
+   */
+  void Submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  /** @return the number of worker threads */
+  size_t GetNumThreads() const { return workers_.size(); }
+
+ private:
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return shutdown_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool shutdown_{false};
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_engine.h
+//
+// Identification: src/include/storage/disk/async_io_engine.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/thread_pool.h"
+
+namespace bustub {
+
+/** The implementations of AsyncIOEngine. */
+enum class IOEngineType {
+  /** io_uring if the kernel supports it, the thread pool otherwise. */
+  AUTO,
+  IO_URING,
+  THREAD_POOL,
+};
+
+/**
+ * One read or write of a contiguous range of a file, submitted to an AsyncIOEngine.
+ */
+struct IORequest {
+  enum class Type { READ, WRITE };
+
+  /** Called once the request is done, with the number of bytes transferred or -errno on failure. */
+  using Callback = std::function<void(int64_t result)>;
+
+  Type type_;
+  int fd_;
+  /** The buffer to read into or write from. It must stay valid until the callback runs. */
+  char *data_;
+  size_t size_;
+  int64_t offset_;
+  Callback callback_;
+};
+
+/**
+ * AsyncIOEngine runs file reads and writes in the background and reports their completion through callbacks. It is
+ * thread-safe: any thread may submit, and callbacks run on a thread owned by the engine, so they must not block on
+ * anything that waits for other requests of the same engine to complete.
+ *
+ * Submitting never blocks on the device. Requests beyond the queue depth wait in the engine until earlier ones
+ * complete.
+ */
+class AsyncIOEngine {
+ public:
+  /**
+   * Creates an engine.
+   * @param type the implementation to use; IO_URING falls back to the thread pool if the kernel rejects io_uring
+   * @param queue_depth the maximum number of requests in flight at the device
+   * @param num_threads the number of worker threads of the thread pool implementation
+   */
+  static std::unique_ptr<AsyncIOEngine> Create(IOEngineType type, size_t queue_depth, size_t num_threads);
+
+  AsyncIOEngine() = default;
+  virtual ~AsyncIOEngine() = default;
+
+  DISALLOW_COPY_AND_MOVE(AsyncIOEngine);
+
+  /**
+   * Submits a single request.
+   * @param request the request to submit
+   */
+  void Submit(IORequest request) {
+    std::vector<IORequest> requests;
+    requests.push_back(std::move(request));
+    SubmitBatch(std::move(requests));
+  }
+
+  /**
+   * Submits several requests at once, which costs a single system call where the implementation allows it.
+   * @param requests the requests to submit
+   */
+  virtual void SubmitBatch(std::vector<IORequest> requests) = 0;
+
+  /** Blocks until every request submitted so far has completed and its callback has returned. */
+  void Drain() {
+    std::unique_lock<std::mutex> lock(drain_latch_);
+    drained_.wait(lock, [this] { return num_pending_ == 0; });
+  }
+
+  /** @return the implementation actually in use */
+  virtual IOEngineType GetType() const = 0;
+
+ protected:
+  /** Must be called for every request when it is submitted. */
+  void OnSubmit(size_t count) { num_pending_ += count; }
+
+  /** Must be called for every request after its callback has returned. */
+  void OnComplete() {
+    if (--num_pending_ == 0) {
+      std::lock_guard<std::mutex> guard(drain_latch_);
+      drained_.notify_all();
+    }
+  }
+
+ private:
+  std::atomic<size_t> num_pending_{0};
+  std::mutex drain_latch_;
+  std::condition_variable drained_;
+};
+
+/**
+ * Portable AsyncIOEngine: worker threads issue blocking pread()/pwrite() calls.
+ */
+class ThreadPoolIOEngine : public AsyncIOEngine {
+ public:
+  /** @param num_threads the number of worker threads, which bounds the number of requests in flight */
+  explicit ThreadPoolIOEngine(size_t num_threads);
+
+  ~ThreadPoolIOEngine() override;
+
+  void SubmitBatch(std::vector<IORequest> requests) override;
+
+  IOEngineType GetType() const override { return IOEngineType::THREAD_POOL; }
+
+ private:
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace bustub
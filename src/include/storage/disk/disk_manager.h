@@ -13,27 +13,59 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/async_io_engine.h"
+#include "storage/disk/free_space_map.h"
 
 namespace bustub {
 
+class ExtentAllocator;
+
+/** When DiskManager forces written data to stable storage. */
+enum class SyncPolicy {
+  /** Never; written data reaches the disk whenever the operating system decides. */
+  NONE,
+  /** fdatasync() after every page write and every log flush. */
+  ALWAYS,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread()/pwrite() on a file descriptor, so there is no shared file offset and any
+ * number of threads can read and write different pages at the same time. The size of the database file is cached.
+ *
+ * Allocated pages are tracked by a FreeSpaceMap kept next to the database file. Deallocated pages are reused before
+ * the file grows, and a reopened database continues allocating where it left off.
+ *
+ * Pages can also be read and written asynchronously through an AsyncIOEngine (io_uring where available, a thread pool
+ * otherwise). Log flushes go through the same engine.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io true to bypass the operating system page cache for the database file (O_DIRECT), if the file
+   * system supports it
+   * @param sync_policy when written data is forced to stable storage
+   * @param io_engine the implementation of asynchronous I/O
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, SyncPolicy sync_policy = SyncPolicy::NONE,
+                       IOEngineType io_engine = IOEngineType::AUTO);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -47,6 +79,17 @@ class DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Write contiguous pages to the database file with as few system calls as possible. Unlike WritePage(), this never
+   * syncs, whatever the sync policy; call Sync() after the last batch.
+   * @param first_page_id id of the first page
+   * @param pages raw data of the pages first_page_id, first_page_id + 1, ...
+   */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages);
+
+  /** Force the pages written so far to stable storage, unless the sync policy is NONE. */
+  void Sync();
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -54,6 +97,41 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /** Called when an asynchronous read or write is done; the argument is false if it failed. */
+  using IOCallback = std::function<void(bool)>;
+
+  /**
+   * Start writing a page to the database file in the background.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay unchanged until the callback runs
+   * @param callback called on an I/O thread once the page is written
+   */
+  void WritePageAsync(page_id_t page_id, const char *page_data, IOCallback callback);
+
+  /**
+   * Start reading a page from the database file in the background.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the callback runs
+   * @param callback called on an I/O thread once the page is read, or right away if it lies past the end of the file
+   */
+  void ReadPageAsync(page_id_t page_id, char *page_data, IOCallback callback);
+
+  /**
+   * Start reading several pages from the database file in the background. The reads are handed to the I/O engine as
+   * one batch, which io_uring submits with a single system call.
+   * @param page_ids ids of the pages
+   * @param[out] pages output buffers, one per page, which must stay valid until the callback of the page runs
+   * @param callbacks one per page, called like the callback of ReadPageAsync()
+   */
+  void ReadPagesAsync(const std::vector<page_id_t> &page_ids, const std::vector<char *> &pages,
+                      std::vector<IOCallback> callbacks);
+
+  /** Wait until every asynchronous read and write submitted so far is done. */
+  void DrainAsyncIO() { io_engine_->Drain(); }
+
+  /** @return the implementation of asynchronous I/O in use */
+  IOEngineType GetIOEngineType() const { return io_engine_->GetType(); }
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -71,17 +149,41 @@ class DiskManager {
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk, reusing the lowest deallocated page if there is one.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage() may return it again. Waits for asynchronous writes of the page
+   * still in flight, whichever buffer pool started them, so that they cannot overwrite the page once it is reused.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /**
+   * Allocate contiguous pages on disk, so that the pages of one table or index lie next to each other in the file.
+   * @param num_pages the number of pages
+   * @return the id of the first allocated page
+   */
+  page_id_t AllocateExtent(size_t num_pages);
+
+  /**
+   * Deallocate contiguous pages on disk, once their asynchronous writes in flight are done.
+   * @param first_page_id id of the first page to deallocate
+   * @param num_pages the number of pages
+   */
+  void DeallocateExtent(page_id_t first_page_id, size_t num_pages);
+
+  /** @return the free space map of the database file */
+  const FreeSpaceMap &GetFreeSpaceMap() const { return *free_space_map_; }
+
+  /** @return the number of pages the database file holds */
+  page_id_t GetNumPages() const { return static_cast<page_id_t>(db_file_size_ / PAGE_SIZE); }
+
+  /** @return true if the database file is opened with O_DIRECT */
+  bool IsDirectIO() const { return direct_io_; }
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +193,9 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of write system calls for pages, which WritePages() issues one per batch */
+  int GetNumWriteCalls() const { return num_write_calls_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -101,18 +206,48 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
+  friend class ExtentAllocator;
+
+  /** Remembers an allocator, so that ShutDown() can give back its unused pages. */
+  void RegisterExtentAllocator(ExtentAllocator *allocator);
+
+  /** Gives back the unused pages of an allocator that is going away, and forgets it. */
+  void UnregisterExtentAllocator(ExtentAllocator *allocator);
+
+  /** Waits until no asynchronous write of a page in [first_page_id, first_page_id + num_pages) is in flight. */
+  void WaitForPendingWrites(page_id_t first_page_id, size_t num_pages);
+
   int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /** Opens (and creates, if needed) a file for reading and writing. Throws if that fails. */
+  static int OpenFile(const std::string &file_name, int flags);
+  /** Opens the database file, with O_DIRECT if direct_io_ is set and the file system supports it. */
+  void OpenDbFile();
+  // descriptor of the log file, opened for appending
+  int log_fd_{-1};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file
+  int db_fd_{-1};
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
-  int num_flushes_;
-  int num_writes_;
+  bool direct_io_;
+  const SyncPolicy sync_policy_;
+  // size of the db file, grown by WritePage
+  std::atomic<int64_t> db_file_size_{0};
+  // tracks which pages are allocated, stored in its own file
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  // the live extent allocators, whose unused pages are given back on shutdown
+  std::unordered_set<ExtentAllocator *> extent_allocators_;
+  std::mutex extent_allocators_latch_;
+  // the pages with asynchronous writes in flight, and how many of them each
+  std::unordered_map<page_id_t, int> pending_writes_;
+  std::mutex pending_writes_latch_;
+  std::condition_variable pending_writes_done_;
+  std::atomic<int> num_flushes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_write_calls_{0};
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // runs asynchronous page I/O and log writes
+  std::unique_ptr<AsyncIOEngine> io_engine_;
 };
 
 }  // namespace bustub
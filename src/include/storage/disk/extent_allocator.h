@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.h
+//
+// Identification: src/include/storage/disk/extent_allocator.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * ExtentAllocator hands out the page ids of one table or index. It reserves extents, i.e. runs of contiguous pages,
+ * from the DiskManager and allocates from the current extent until it is used up. Pages of different tables therefore
+ * do not interleave in the file even when they grow at the same time, and scanning a table or walking the leaves of an
+ * index reads the file mostly sequentially.
+ *
+ * The unused rest of the current extent is given back when the allocator is destroyed or when the DiskManager shuts
+ * down, whichever happens first. Allocating after the DiskManager shut down returns INVALID_PAGE_ID.
+ */
+class ExtentAllocator {
+  friend class DiskManager;
+
+ public:
+  /**
+   * @param disk_manager the disk manager to reserve extents from
+   * @param extent_size the number of pages reserved at a time
+   */
+  ExtentAllocator(DiskManager *disk_manager, size_t extent_size);
+
+  ~ExtentAllocator();
+
+  DISALLOW_COPY_AND_MOVE(ExtentAllocator);
+
+  /** @return the id of a new page, the next one of the current extent */
+  page_id_t AllocatePage();
+
+  /**
+   * Gives back a page that was allocated but is not going to be used.
+   * @param page_id id of the page, as returned by AllocatePage()
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return the number of pages reserved at a time */
+  size_t GetExtentSize() const { return extent_size_; }
+
+ private:
+  /** Gives back the rest of the current extent and forgets the disk manager. Called by the disk manager. */
+  void Detach();
+
+  /** Nullptr once detached. */
+  DiskManager *disk_manager_;
+  const size_t extent_size_;
+  /** The unused rest of the current extent, [next_page_id_, extent_end_). */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t extent_end_{INVALID_PAGE_ID};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
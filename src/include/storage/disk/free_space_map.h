@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap remembers which pages of a database file are allocated, so that pages freed by DeallocatePage can be
+ * handed out again instead of growing the file forever.
+ *
+ * The map is a bitmap with one bit per page, set while the page is allocated. It is stored in dedicated pages of a
+ * file next to the database file ("foo.db" keeps its map in "foo.fsm"); map page i covers the page ids
+ * [i * BITS_PER_PAGE, (i + 1) * BITS_PER_PAGE). Every change writes the map page it touched straight through, so the
+ * map on disk never claims that a page in use is free.
+ *
+ * Allocation returns the lowest free page id, which keeps the file compact and fills holes close to their neighbours.
+ * Runs of contiguous pages (extents) go into the lowest hole large enough for them, or at the end of the file.
+ */
+class FreeSpaceMap {
+ public:
+  /** The number of page ids one map page covers. */
+  static constexpr page_id_t BITS_PER_PAGE = PAGE_SIZE * 8;
+
+  /**
+   * Opens the map stored in file_name, creating it if needed.
+   * @param file_name the file holding the map
+   * @param num_db_pages the number of pages the database file holds. An empty database file discards a stale map; a
+   * database file without a map gets one in which all of its pages are allocated.
+   * @param sync true to fdatasync() the map after every change
+   */
+  FreeSpaceMap(const std::string &file_name, page_id_t num_db_pages, bool sync = false);
+
+  ~FreeSpaceMap();
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /**
+   * Allocates count contiguous pages.
+   * @param count the number of pages
+   * @return the first of the lowest count contiguous free page ids, now marked allocated
+   */
+  page_id_t Allocate(size_t count = 1);
+
+  /**
+   * Marks pages free, so that Allocate() may return them again. Pages that are already free are skipped.
+   * @param page_id id of the first page to free
+   * @param count the number of contiguous pages to free
+   */
+  void Deallocate(page_id_t page_id, size_t count = 1);
+
+  /** @return true if page_id is allocated */
+  bool IsAllocated(page_id_t page_id) const;
+
+  /** @return one past the highest page id ever allocated, i.e. the page id a growing file hands out next */
+  page_id_t GetNextPageId() const;
+
+  /** @return the number of free page ids below GetNextPageId() */
+  size_t GetNumFreePages() const;
+
+  /** Closes the map file. The map must not be used afterwards. */
+  void Close();
+
+ private:
+  static constexpr size_t WORDS_PER_PAGE = PAGE_SIZE / sizeof(uint64_t);
+
+  /** Sets or clears the bit of page_id, growing the bitmap if needed. Caller must hold latch_. */
+  void SetBit(page_id_t page_id, bool allocated);
+
+  /** Writes the map page holding the bit of page_id. Caller must hold latch_. */
+  void WriteMapPage(page_id_t page_id);
+
+  /** Writes the map pages holding the bits of [page_id, page_id + count). Caller must hold latch_. */
+  void WriteMapPages(page_id_t page_id, size_t count) {
+    const page_id_t last = page_id + static_cast<page_id_t>(count) - 1;
+    for (page_id_t map_page = page_id / BITS_PER_PAGE; map_page <= last / BITS_PER_PAGE; ++map_page) {
+      WriteMapPage(map_page * BITS_PER_PAGE);
+    }
+  }
+
+  /** @return the first page of the lowest run of count free pages, which may extend past next_page_id_ */
+  page_id_t FindFreeRun(size_t count) const;
+
+  bool IsAllocatedLocked(page_id_t page_id) const {
+    const size_t word = page_id / 64;
+    return word < bitmap_.size() && (bitmap_[word] >> (page_id % 64) & 1) != 0;
+  }
+
+  std::string file_name_;
+  int fd_{-1};
+  const bool sync_;
+  /** The bitmap, always a whole number of map pages long and covering at least [0, next_page_id_). */
+  std::vector<uint64_t> bitmap_;
+  page_id_t next_page_id_{0};
+  /** No page id below this one is free. */
+  page_id_t first_free_hint_{0};
+  size_t num_free_pages_{0};
+  mutable std::mutex latch_;
+};
+
+}  // namespace bustub
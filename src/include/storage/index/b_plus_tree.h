@@ -10,10 +10,16 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <memory>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -37,44 +43,61 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
-  using LeafPage = BPlusTreeLeafPage<KeyType, page_id_t, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  /**
+   * @param buffer_pool_manager the buffer pool that holds the pages of the tree
+   * @param header_buffer_pool_manager the buffer pool that holds the header page, where the root page id is recorded;
+   * nullptr if that is buffer_pool_manager. All trees of a database must go through the same pool for the header page.
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     BufferPoolManager *header_buffer_pool_manager = nullptr);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
-  BPlusTreePage *FetchPage(page_id_t page_id);
-
   // Insert a key-value pair into this B+ tree.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
+  // Insert many key-value pairs at once, in any order; entries are sorted in place. Returns how many were inserted:
+  // like Insert, this skips keys that are in the tree already.
+  size_t InsertBatch(std::vector<std::pair<KeyType, ValueType>> *entries, Transaction *transaction = nullptr);
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
+  // Build this B+ tree, which must be empty, from the key-value pairs in [first, last) at once, filling every page up
+  // to fill_factor. Returns false if the tree was not empty.
+  template <typename InputIterator>
+  bool BulkLoad(InputIterator first, InputIterator last, double fill_factor = BULK_LOAD_FILL_FACTOR) {
+    std::vector<std::pair<KeyType, ValueType>> entries(first, last);
+    return BulkLoad(&entries, fill_factor);
+  }
+
+  // Same, sorting entries in place if needed. Of several pairs with the same key, the first one is kept.
+  bool BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries, double fill_factor = BULK_LOAD_FILL_FACTOR);
+
   // return the value associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
-  B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPage(const KeyType &key, bool leftMost = false);
+  // look up many keys at once, in any order: (*result)[i] is the value of keys[i] if (*found)[i] is true. Returns how
+  // many keys were found
+  size_t GetValues(const std::vector<KeyType> &keys, std::vector<ValueType> *result, std::vector<bool> *found,
+                   Transaction *transaction = nullptr);
+
+  // return the read-latched leaf page that may contain key, or the leftmost leaf page; empty if the tree is empty
+  ReadPageGuard FindLeafPage(const KeyType &key, bool left_most = false);
 
   // index iterator
   INDEXITERATOR_TYPE begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
   INDEXITERATOR_TYPE end();
 
-  void Print(BufferPoolManager *bpm) {
-    ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id_)->GetData()), bpm);
-  }
+  void Print(BufferPoolManager *bpm);
 
-  void Draw(BufferPoolManager *bpm, const std::string &outf) {
-    std::ofstream out(outf);
-    out << "digraph G {" << std::endl;
-    ToGraph(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id_)->GetData()), bpm, out);
-    out << "}" << std::endl;
-    out.close();
-  }
+  void Draw(BufferPoolManager *bpm, const std::string &outf);
 
   // read data from file and insert one by one
   void InsertFromFile(const std::string &file_name, Transaction *transaction = nullptr);
@@ -84,42 +107,122 @@ class BPlusTree {
   // expose for test purpose
 
  private:
+  /**
+   * The latches a modification holds. Inserts, and removes that leave their leaf full enough, hold the structure latch
+   * shared and latch one page at a time on their way down, remembering the path they took. Removes that merge or
+   * redistribute pages hold it exclusively, and keep the pages they latched on their way down from the root in the
+   * write set, root first; a merge finds the parent of a page one entry up. Once a page is safe, i.e. the remove
+   * cannot merge it, nothing above it can change, so its ancestors are released and it becomes the first page of the
+   * write set.
+   */
+  struct Context {
+    ~Context() {
+      ReleaseRootLatch();
+      write_set_.clear();
+      if (structure_latch_ != nullptr) {
+        if (structure_exclusive_) {
+          structure_latch_->WUnlock();
+        } else {
+          structure_latch_->RUnlock();
+        }
+      }
+    }
+    /** Releases the root latch, if held. */
+    void ReleaseRootLatch() {
+      if (root_latch_ != nullptr) {
+        root_latch_->WUnlock();
+        root_latch_ = nullptr;
+      }
+    }
+    /** Releases the root latch and every page but the last one. */
+    void ReleaseAncestors() {
+      ReleaseRootLatch();
+      while (write_set_.size() > 1) {
+        write_set_.pop_front();
+      }
+    }
+    /** @return true if the first page of the write set is the root, which it is as long as the root latch is held */
+    bool HoldsRoot() const { return root_latch_ != nullptr; }
+    /** The structure latch, if held; released when the context goes away. */
+    ReaderWriterLatch *structure_latch_{nullptr};
+    bool structure_exclusive_{false};
+    /** The root latch, if held in write mode; released when the context goes away. */
+    ReaderWriterLatch *root_latch_{nullptr};
+    std::deque<WritePageGuard> write_set_;
+    /** The ids of the pages above the latched one, root first, as a descent latching one page at a time saw them. */
+    std::vector<page_id_t> path_;
+  };
+
+  // fetch or create pages of this tree; throw an out of memory exception if every frame is pinned
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+  WritePageGuard NewPage(page_id_t *page_id);
+
+  // find the leaf page that may contain key without latching the pages above it; false if it has to start over
+  bool FindLeafPageOptimistic(const KeyType &key, ReadPageGuard *leaf_guard);
+
+  // write-latch the page on level that covers key, remembering the path to it
+  WritePageGuard FindPageWrite(const KeyType &key, int level, Context *context);
+
+  // latch the path from the root to the leaf page that may contain key, keeping no more of it than a remove may change
+  void FindLeafPageWrite(const KeyType &key, Context *context);
+
+  // return true if a remove cannot merge the page, so that it will not touch the parent
+  bool IsSafe(const BPlusTreePage *page, bool is_root) const;
+
+  // move right from the latched page as long as key lies at or beyond its high key
+  template <typename Guard>
+  void MoveRight(const KeyType &key, Guard *guard);
+
+  // return the right sibling of the page if key lies at or beyond its high key, INVALID_PAGE_ID otherwise
+  page_id_t RightSibling(const BPlusTreePage *page, const KeyType &key) const;
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  bool StartNewTreeIfEmpty(const KeyType &key, const ValueType &value, Context *context);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  bool InsertIntoLeaf(WritePageGuard *leaf_guard, const KeyType &key, const ValueType &value, Context *context);
 
-  template <typename N>
-  N *Split(N *node);
+  void InsertIntoParent(page_id_t old_page_id, const KeyType &key, page_id_t new_page_id, int level, Context *context);
 
-  template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  void Rebalance(const KeyType &key);
+
+  template <typename N, typename V>
+  std::vector<std::pair<KeyType, page_id_t>> BuildLevel(const std::vector<std::pair<KeyType, V>> &entries, int level,
+                                                        int max_size, double fill_factor);
 
   template <typename N>
-  bool Coalesce(N *&neighbor_node, N *&node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-                int index, Transaction *transaction = nullptr);
+  page_id_t Split(N *node, KeyType *middle_key);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void CoalesceOrRedistribute(Context *context);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  void AdjustRoot(Context *context);
 
   void UpdateRootPageId(int insert_record = 0);
 
   /* Debug Routines for FREE!! */
-  void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
+  void ToGraph(const BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
-  void ToString(BPlusTreePage *page, BufferPoolManager *bpm) const;
+  void ToString(const BPlusTreePage *page, BufferPoolManager *bpm) const;
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // protects root_page_id_: latched readers hold it until they latched the root page, writers while they change it.
+  // Optimistic readers load root_page_id_ without it.
+  ReaderWriterLatch root_latch_;
+  // held shared by inserts and removes, and exclusively by removes that merge or redistribute pages. Those never run
+  // into a split whose new page is not linked into the parent yet, and no page is deleted under a descent that
+  // remembered it on its path.
+  ReaderWriterLatch structure_latch_;
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
+  BufferPoolManager *header_buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  // hands out the ids of new pages of this tree, so that its pages, and above all its leaf chain, stay contiguous
+  std::unique_ptr<ExtentAllocator> extent_allocator_;
 };
 
 }  // namespace bustub
@@ -13,6 +13,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
@@ -25,7 +26,13 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param buffer_pool_manager the buffer pool that holds the pages of the index
+   * @param header_buffer_pool_manager the buffer pool that holds the header page, nullptr if that is
+   * buffer_pool_manager
+   */
+  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
+                 BufferPoolManager *header_buffer_pool_manager = nullptr);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
@@ -33,6 +40,13 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Fills the empty index with all entries at once, instead of inserting them one by one.
+   * @param entries the keys and their rids, in any order; sorted in place
+   * @return false if the index was not empty
+   */
+  bool BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries);
+
   INDEXITERATOR_TYPE GetBeginIterator();
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
@@ -20,12 +20,19 @@ namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaf chain of a B+ tree. It keeps the leaf it is on pinned and read-latched through a page
+ * guard, and starts reading the next leaf while the current one is scanned. The end iterator holds no page.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
-  // you may define your own constructor based on your member variables
-  IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, const int index, BufferPoolManager *bfm)
-      : current_leaf_node_(leaf), index_(index), buffer_pool_manager_(bfm) {}
+  /**
+   * @param bpm the buffer pool the leaf pages live in
+   * @param guard the leaf to start on, or an empty guard for the end iterator
+   * @param index the position in the leaf to start at; past the end of the leaf moves on to the next one
+   */
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index);
   ~IndexIterator();
 
   bool isEnd();
@@ -34,14 +41,20 @@ class IndexIterator {
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &iter) const { return iter.index_ == index_; }
+  bool operator==(const IndexIterator &iter) const { return page_id_ == iter.page_id_ && index_ == iter.index_; }
 
-  bool operator!=(const IndexIterator &iter) const { return iter.index_ != index_; }
+  bool operator!=(const IndexIterator &iter) const { return !(*this == iter); }
 
  private:
-  B_PLUS_TREE_LEAF_PAGE_TYPE *current_leaf_node_;
-  int index_;
+  /** Move on to the next leaf while index_ is past the end of the current one. */
+  void SkipExhaustedLeaves();
+
+  const B_PLUS_TREE_LEAF_PAGE_TYPE *Leaf() const { return guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>(); }
+
   BufferPoolManager *buffer_pool_manager_;
+  ReadPageGuard guard_;
+  page_id_t page_id_;
+  int index_;
 };
 
 }  // namespace bustub
@@ -19,7 +19,8 @@ namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
 #define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+// one slot stays spare for the entry that overflows a full page right before it splits
+#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - sizeof(KeyType)) / sizeof(MappingType) - 1)
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
@@ -31,26 +32,35 @@ namespace bustub {
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 28 bytes plus the size of a key in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ------------------------------------------------------------
+ * | PageId (4) | Level (4) | NextPageId (4) | HighKey (key size)
+ *  ------------------------------------------------------------
+ *
+ * Leaves are B-link pages: every leaf points to its right sibling, and its
+ * high key is the least key that belongs to the pages right of it. A reader
+ * that finds its key at or beyond the high key came in while the leaf was
+ * split, before the parent learned about the new sibling, and moves right. The
+ * last leaf has no sibling and no high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, int max_size = LEAF_PAGE_SIZE);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool IsBeyondHighKey(const KeyType &key, const KeyComparator &comparator) const;
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  const MappingType &GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
@@ -58,16 +68,17 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
 
   // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient, BufferPoolManager *buffer_manager);
-  void MoveAllTo(BPlusTreeLeafPage *recipient, const KeyType &midddle_key, BufferPoolManager *buffer_manager);
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient, const KeyType &midddle_key, BufferPoolManager *buffer_manager);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, const KeyType &midddle_key, BufferPoolManager *buffer_manager);
+  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
   void CopyNFrom(MappingType *items, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item);
   page_id_t next_page_id_;
+  KeyType high_key_;
   MappingType array_[0];
 };
 }  // namespace bustub
@@ -33,17 +33,23 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
+ * Pages do not point to their parents. The tree remembers the path it took
+ * down from the root instead, so that a split or a merge never has to touch
+ * the children of the pages it moves entries between. The level tells how far
+ * up a page is, counting from the leaves at level 0, so that the tree can find
+ * the page at a given level again.
+ *
  * Header format (size in byte, 24 bytes in total):
  * ----------------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
- * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | PageId(4) |
  * ----------------------------------------------------------------------------
+ * ---------------
+ * | Level (4) |
+ * ---------------
  */
 class BPlusTreePage {
  public:
   bool IsLeafPage() const;
-  bool IsRootPage() const;
   void SetPageType(IndexPageType page_type);
 
   int GetSize() const;
@@ -52,14 +58,15 @@ class BPlusTreePage {
 
   int GetMaxSize() const;
   void SetMaxSize(int max_size);
+  // the least number of entries a page other than the root may hold
   int GetMinSize() const;
 
-  page_id_t GetParentPageId() const;
-  void SetParentPageId(page_id_t parent_page_id);
-
   page_id_t GetPageId() const;
   void SetPageId(page_id_t page_id);
 
+  int GetLevel() const;
+  void SetLevel(int level);
+
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
  private:
@@ -68,8 +75,8 @@ class BPlusTreePage {
   lsn_t lsn_ __attribute__((__unused__));
   int size_ __attribute__((__unused__));
   int max_size_ __attribute__((__unused__));
-  page_id_t parent_page_id_ __attribute__((__unused__));
   page_id_t page_id_ __attribute__((__unused__));
+  int level_ __attribute__((__unused__));
 };
 
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 
@@ -23,15 +26,27 @@ namespace bustub {
 /**
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
- * pin count, dirty flag, page id, etc.
+ * pin count, dirty flag, page id, etc. The data itself lives apart from the Page, in the frame arena of the buffer
+ * pool, so that the memory of unused frames can be given back. Pages start on a cache line of their own, so threads
+ * pinning neighbouring pages do not contend on the same line.
+ *
+ * The book-keeping fields are atomic, because the buffer pool pins and unpins resident pages without a latch.
+ *
+ * Besides the latch, a page can be read optimistically. Every change to the page data bumps a version counter twice,
+ * once before and once after, so that the version is odd while the data is in flux: writers do so in WLatch() and
+ * WUnlatch(), the buffer pool when it takes a frame away from its page and when it publishes the next page in it.
+ * A reader takes a snapshot of the version with BeginOptimisticRead(), reads the data without any latch or pin, and
+ * then asks ValidateOptimisticRead() whether the version is still the same. If not, what it read may be torn and it
+ * has to start over. Readers share nothing they write to, so pages that many threads read stay cached on every core.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
-  friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
+  friend class FrameArena;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The frame arena that owns the page gives it its data. */
+  Page() = default;
 
   /** Default destructor. */
   ~Page() = default;
@@ -40,19 +55,25 @@ class Page {
   inline char *GetData() { return data_; }
 
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() { return page_id_.load(std::memory_order_acquire); }
 
-  /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  /** @return the pin count of this page. A frame the buffer pool is reading, evicting or keeping free has none. */
+  inline int GetPinCount() { return std::max(pin_count_.load(), 0); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    BeginChange();
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    EndChange();
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +81,27 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page data.
+   * @param[out] version the version to validate the read against
+   * @return false if the page is being changed right now, in which case there is no point in reading it
+   */
+  inline bool BeginOptimisticRead(uint64_t *version) const {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read of the page data.
+   * @param version the version BeginOptimisticRead() returned
+   * @return true if the page has not changed since, so that everything read in between is consistent
+   */
+  inline bool ValidateOptimisticRead(uint64_t version) const {
+    // Keep the reads of the page data from moving past the second look at the version.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -78,14 +120,36 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** Make the version odd before the page data changes, so that overlapping optimistic reads fail. */
+  inline void BeginChange() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+    // Keep the writes to the page data from moving ahead of the version.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Make the version even again once the page data is consistent. */
+  inline void EndChange() { version_.fetch_add(1, std::memory_order_release); }
+
+  /** The actual data that is stored within a page, PAGE_SIZE bytes in the frame arena. */
+  char *data_{nullptr};
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /** The pin count of this page, or a negative value while the buffer pool owns the frame exclusively. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /**
+   * True while the replacer of the buffer pool holds the frame. Written under the instance latch; read without it when
+   * unpinning, which only needs the latch if the frame has to go back into the replacer.
+   */
+  std::atomic<bool> in_replacer_ = false;
+  /**
+   * Set when the page is fetched without a buffer ring, cleared when a page is read into the frame. A scan only
+   * recycles the frames of its ring whose page nobody else has fetched since the scan read it.
+   */
+  std::atomic<bool> shared_use_ = false;
+  /** Bumped before and after every change to the page data; odd while the data is changing. */
+  std::atomic<uint64_t> version_ = 0;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,219 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds a pin on a page and gives it back when it goes out of scope, so that no path through the
+ * caller, early returns included, can leak the pin. Guards are move-only: moving one hands the pin over, and assigning
+ * to a guard first releases the page it held before.
+ *
+ * The guard remembers whether the page was modified through AsMut() or GetDataMut() and unpins it accordingly. A guard
+ * is empty if the buffer pool could not provide the page, or after Drop() or a move.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Takes over a pin on page, which the caller already holds.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned page, or nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  DISALLOW_COPY(BasicPageGuard);
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  /** Unpins the page, unless the guard is empty. */
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpins the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /**
+   * Takes the read latch of the page and hands the pin over to a read guard, without unpinning in between.
+   * @return the read guard; this guard is empty afterwards
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Takes the write latch of the page and hands the pin over to a write guard, without unpinning in between.
+   * @return the write guard; this guard is empty afterwards
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID if the guard is empty */
+  page_id_t PageId() const { return page_ != nullptr ? page_->GetPageId() : INVALID_PAGE_ID; }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return page_->GetData(); }
+
+  /** @return the data of the guarded page, reinterpreted as T */
+  template <class T>
+  const T *As() const {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the data of the guarded page, which is unpinned dirty */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the data of the guarded page reinterpreted as T, which is unpinned dirty */
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /** @return the guarded page as T, a page type derived from Page such as HeaderPage; it is unpinned dirty */
+  template <class T>
+  T *AsPageMut() {
+    is_dirty_ = true;
+    return reinterpret_cast<T *>(page_);
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds a pin and the read latch on a page, and releases both, latch first, when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Takes over a pin and the read latch on page, which the caller already holds.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned and read-latched page, or nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  DISALLOW_COPY(ReadPageGuard);
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  /** Releases the latch and the pin, unless the guard is empty. */
+  ~ReadPageGuard() { Drop(); }
+
+  /** Releases the latch and the pin now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID if the guard is empty */
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, reinterpreted as T */
+  template <class T>
+  const T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds a pin and the write latch on a page, and releases both, latch first, when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Takes over a pin and the write latch on page, which the caller already holds.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned and write-latched page, or nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  DISALLOW_COPY(WritePageGuard);
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  /** Releases the latch and the pin, unless the guard is empty. */
+  ~WritePageGuard() { Drop(); }
+
+  /** Releases the latch and the pin now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID if the guard is empty */
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, reinterpreted as T */
+  template <class T>
+  const T *As() const {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the guarded page, which is unpinned dirty */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  /** @return the data of the guarded page reinterpreted as T, which is unpinned dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  /** @return the guarded page as T, a page type derived from Page such as HeaderPage; it is unpinned dirty */
+  template <class T>
+  T *AsPageMut() {
+    return guard_.AsPageMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
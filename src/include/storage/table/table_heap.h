@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -22,7 +24,8 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages. New pages come from extents reserved for this table, so that the list
+ * runs through the file in order and a scan reads it sequentially.
  */
 class TableHeap {
   friend class TableIterator;
@@ -95,11 +98,12 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param strategy if not nullptr, the ring of frames of the scan performing the read
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
-  /** @return the begin iterator of this table */
+  /** @return the begin iterator of this table, which reads the table through a private ring of buffer frames */
   TableIterator Begin(Transaction *txn);
 
   /** @return the end iterator of this table */
@@ -113,6 +117,8 @@ class TableHeap {
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** Hands out the ids of new pages of this table. */
+  std::unique_ptr<ExtentAllocator> extent_allocator_;
 };
 
 }  // namespace bustub
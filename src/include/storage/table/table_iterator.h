@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -24,15 +26,29 @@ class TableHeap;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ *
+ * Pages the scan reads from disk are fetched through a buffer access strategy, so a scan over a large table recycles a
+ * small ring of frames instead of flushing the whole buffer pool. Copies of an iterator share the ring. The iterator
+ * also reads ahead along the page list, up to PREFETCH_DEPTH pages past the current one, so a scan over a cold table
+ * rarely waits for a read. Only pages of the table are ever read ahead.
  */
 class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        prefetch_page_id_(other.prefetch_page_id_),
+        prefetch_next_(other.prefetch_next_),
+        prefetch_tail_(other.prefetch_tail_),
+        prefetch_ahead_(other.prefetch_ahead_),
+        prefetch_issued_(other.prefetch_issued_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +68,37 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    prefetch_page_id_ = other.prefetch_page_id_;
+    prefetch_next_ = other.prefetch_next_;
+    prefetch_tail_ = other.prefetch_tail_;
+    prefetch_ahead_ = other.prefetch_ahead_;
+    prefetch_issued_ = other.prefetch_issued_;
     return *this;
   }
 
  private:
+  /**
+   * Walk the page list past the page the scan is on, as far as the pages are resident, and prefetch the first page
+   * that is not. The next page id of that one is only known once it has been read, so at most one read is in flight.
+   * @param page_id the page the scan is on
+   * @param next_page_id the page following it
+   */
+  void PrefetchAhead(page_id_t page_id, page_id_t next_page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Ring of frames the scan recycles, nullptr to fetch pages into the shared pool. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** The page the scan was on at the last call of PrefetchAhead(), and the page following it. */
+  page_id_t prefetch_page_id_{INVALID_PAGE_ID};
+  page_id_t prefetch_next_{INVALID_PAGE_ID};
+  /** The farthest page of the list the iterator has reached, prefetch_ahead_ pages past the page the scan is on. */
+  page_id_t prefetch_tail_{INVALID_PAGE_ID};
+  int prefetch_ahead_{0};
+  /** Whether prefetch_tail_ has been prefetched already. */
+  bool prefetch_issued_{false};
 };
 
 }  // namespace bustub
@@ -0,0 +1,308 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_engine.cpp
+//
+// Identification: src/storage/disk/async_io_engine.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_io_engine.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <thread>  // NOLINT
+#include <utility>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define BUSTUB_HAVE_IO_URING
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/** Runs a request with blocking system calls. @return the number of bytes transferred, or -errno */
+static int64_t RunBlocking(const IORequest &request) {
+  size_t done = 0;
+  while (done < request.size_) {
+    ssize_t n = request.type_ == IORequest::Type::READ
+                    ? pread(request.fd_, request.data_ + done, request.size_ - done, request.offset_ + done)
+                    : pwrite(request.fd_, request.data_ + done, request.size_ - done, request.offset_ + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+ThreadPoolIOEngine::ThreadPoolIOEngine(size_t num_threads) : pool_(std::make_unique<ThreadPool>(num_threads)) {}
+
+ThreadPoolIOEngine::~ThreadPoolIOEngine() { Drain(); }
+
+void ThreadPoolIOEngine::SubmitBatch(std::vector<IORequest> requests) {
+  OnSubmit(requests.size());
+  for (auto &request : requests) {
+    pool_->Submit([this, request = std::move(request)] {
+      request.callback_(RunBlocking(request));
+      OnComplete();
+    });
+  }
+}
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/**
+ * AsyncIOEngine on top of io_uring, driven through the raw system calls so that liburing is not needed. Submitters
+ * fill the submission queue under a latch and enter the kernel once per batch; a completion thread reaps the
+ * completion queue and runs the callbacks.
+ */
+class IoUringEngine : public AsyncIOEngine {
+ public:
+  /** @return the engine, or nullptr if the kernel does not support io_uring */
+  static std::unique_ptr<IoUringEngine> TryCreate(unsigned queue_depth) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    auto engine = std::unique_ptr<IoUringEngine>(new IoUringEngine(ring_fd));
+    if (!engine->MapRings(params)) {
+      return nullptr;
+    }
+    engine->completion_thread_ = std::thread([engine = engine.get()] { engine->ReapCompletions(); });
+    return engine;
+  }
+
+  ~IoUringEngine() override {
+    if (completion_thread_.joinable()) {
+      Drain();
+      // A no-op without a request tells the completion thread to stop.
+      {
+        std::lock_guard<std::mutex> guard(submit_latch_);
+        io_uring_sqe *sqe = NextSqe();
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        CommitSqes(1);
+      }
+      completion_thread_.join();
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    close(ring_fd_);
+  }
+
+  void SubmitBatch(std::vector<IORequest> requests) override {
+    OnSubmit(requests.size());
+    std::lock_guard<std::mutex> guard(submit_latch_);
+    for (auto &request : requests) {
+      backlog_.push_back(std::make_unique<InFlight>(std::move(request)));
+    }
+    SubmitBacklog();
+  }
+
+  IOEngineType GetType() const override { return IOEngineType::IO_URING; }
+
+ private:
+  /** A request handed to the kernel; its address is the user_data of the submission. */
+  struct InFlight {
+    explicit InFlight(IORequest request) : request_(std::move(request)) {
+      iov_.iov_base = request_.data_;
+      iov_.iov_len = request_.size_;
+    }
+    IORequest request_;
+    iovec iov_;
+  };
+
+  explicit IoUringEngine(int ring_fd) : ring_fd_(ring_fd) {}
+
+  bool MapRings(const io_uring_params &params) {
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ptr_ = single_mmap ? sq_ptr_
+                          : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                 IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+
+    auto *sq = static_cast<char *>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    auto *cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /** @return a cleared submission queue entry at the local tail. Caller must hold submit_latch_. */
+  io_uring_sqe *NextSqe() {
+    const unsigned index = (*sq_tail_ + num_unsubmitted_) & sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++num_unsubmitted_;
+    return sqe;
+  }
+
+  /** Publishes the prepared entries and enters the kernel once for all of them. Caller must hold submit_latch_. */
+  void CommitSqes(unsigned count) {
+    __atomic_store_n(sq_tail_, *sq_tail_ + num_unsubmitted_, __ATOMIC_RELEASE);
+    num_unsubmitted_ = 0;
+    unsigned submitted = 0;
+    while (submitted < count) {
+      int rc = syscall(__NR_io_uring_enter, ring_fd_, count - submitted, 0, 0, nullptr, 0);
+      if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_ERROR("io_uring_enter failed: %s", strerror(errno));
+        break;
+      }
+      submitted += rc > 0 ? rc : 0;
+    }
+  }
+
+  /**
+   * Moves as many backlogged requests into the ring as the queue depth allows. The completion queue holds twice the
+   * submission queue, so keeping at most sq_entries_ requests in flight can never overflow it. Caller must hold
+   * submit_latch_.
+   */
+  void SubmitBacklog() {
+    unsigned count = 0;
+    while (!backlog_.empty() && num_in_flight_ < sq_entries_) {
+      InFlight *in_flight = backlog_.front().release();
+      backlog_.pop_front();
+      io_uring_sqe *sqe = NextSqe();
+      sqe->opcode = in_flight->request_.type_ == IORequest::Type::READ ? IORING_OP_READV : IORING_OP_WRITEV;
+      sqe->fd = in_flight->request_.fd_;
+      sqe->addr = reinterpret_cast<uint64_t>(&in_flight->iov_);
+      sqe->len = 1;
+      sqe->off = in_flight->request_.offset_;
+      sqe->user_data = reinterpret_cast<uint64_t>(in_flight);
+      ++num_in_flight_;
+      ++count;
+    }
+    if (count > 0) {
+      CommitSqes(count);
+    }
+  }
+
+  void ReapCompletions() {
+    while (true) {
+      const unsigned head = *cq_head_;
+      if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        continue;
+      }
+      const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+      std::unique_ptr<InFlight> in_flight(reinterpret_cast<InFlight *>(cqe.user_data));
+      int64_t result = cqe.res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      if (in_flight == nullptr) {
+        return;
+      }
+
+      // The kernel cancels the requests of a thread that exits before they are done, e.g. writes of pages evicted by a
+      // short-lived worker. Reading or writing the same bytes again does no harm, so they are run again synchronously.
+      if (result == -ECANCELED) {
+        result = RunBlocking(in_flight->request_);
+      }
+      // The kernel may transfer fewer bytes than asked for; finish the request synchronously in that case.
+      if (result >= 0 && static_cast<size_t>(result) < in_flight->request_.size_) {
+        IORequest rest = in_flight->request_;
+        rest.data_ += result;
+        rest.size_ -= result;
+        rest.offset_ += result;
+        const int64_t rest_result = rest.size_ > 0 ? RunBlocking(rest) : 0;
+        result = rest_result < 0 ? rest_result : result + rest_result;
+      }
+      {
+        std::lock_guard<std::mutex> guard(submit_latch_);
+        --num_in_flight_;
+        SubmitBacklog();
+      }
+      in_flight->request_.callback_(result);
+      OnComplete();
+    }
+  }
+
+  int ring_fd_;
+  void *sq_ptr_{MAP_FAILED};
+  void *cq_ptr_{MAP_FAILED};
+  void *sqes_{MAP_FAILED};
+  size_t sq_size_{0};
+  size_t cq_size_{0};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned sq_entries_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+
+  /** Protects the submission queue, backlog_ and num_in_flight_. */
+  std::mutex submit_latch_;
+  /** Entries prepared after the published tail but not committed yet. */
+  unsigned num_unsubmitted_{0};
+  unsigned num_in_flight_{0};
+  /** Requests waiting for room in the ring. */
+  std::deque<std::unique_ptr<InFlight>> backlog_;
+  std::thread completion_thread_;
+};
+
+#endif
+
+std::unique_ptr<AsyncIOEngine> AsyncIOEngine::Create(IOEngineType type, size_t queue_depth, size_t num_threads) {
+#ifdef BUSTUB_HAVE_IO_URING
+  if (type != IOEngineType::THREAD_POOL) {
+    if (auto engine = IoUringEngine::TryCreate(queue_depth); engine != nullptr) {
+      return engine;
+    }
+    LOG_INFO("io_uring is not available, falling back to the thread pool I/O engine");
+  }
+#endif
+  return std::make_unique<ThreadPoolIOEngine>(num_threads);
+}
+
+}  // namespace bustub
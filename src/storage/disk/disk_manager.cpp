@@ -10,27 +10,126 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/extent_allocator.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/**
+ * pread() until size bytes are read or the end of the file is reached.
+ * @return the number of bytes read, or -1 on error
+ */
+static ssize_t ReadFully(int fd, char *data, size_t size, off_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pread(fd, data + done, size - done, offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -1;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+/**
+ * pwrite() all size bytes.
+ * @return false on error
+ */
+static bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+/**
+ * pwritev() all of iov, advancing past whatever a short write did write.
+ * @return false on error
+ */
+static bool WriteVectorFully(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+  while (iovcnt > 0) {
+    ssize_t n = pwritev(fd, iov, iovcnt, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    offset += n;
+    while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+      n -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+/**
+ * O_DIRECT transfers need a buffer aligned to the logical block size. Page frames are not necessarily aligned, so
+ * direct I/O goes through this per-thread bounce buffer when they are not.
+ */
+static char *AlignedBuffer() {
+  struct FreeDeleter {
+    void operator()(char *p) const { free(p); }  // NOLINT
+  };
+  thread_local std::unique_ptr<char, FreeDeleter> buffer(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)));
+  return buffer.get();
+}
+
+static bool IsAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0; }
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, SyncPolicy sync_policy, IOEngineType io_engine)
+    : file_name_(db_file),
+      direct_io_(direct_io),
+      sync_policy_(sync_policy),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      io_engine_(AsyncIOEngine::Create(io_engine, ASYNC_IO_QUEUE_DEPTH, ASYNC_IO_THREADS)) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -38,87 +137,249 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+  log_fd_ = OpenFile(log_name_, O_APPEND);
+  OpenDbFile();
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = stat_buf.st_size;
   }
+  free_space_map_ = std::make_unique<FreeSpaceMap>(file_name_.substr(0, n) + ".fsm", GetNumPages(),
+                                                   sync_policy_ == SyncPolicy::ALWAYS);
+  buffer_used = nullptr;
+}
+
+DiskManager::~DiskManager() { ShutDown(); }
+
+int DiskManager::OpenFile(const std::string &file_name, int flags) {
+  // Creates the file if it does not exist yet.
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT | flags, 0644);
+  if (fd < 0) {
+    throw Exception("can't open " + file_name + ": " + strerror(errno));
+  }
+  return fd;
+}
 
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+void DiskManager::OpenDbFile() {
+#ifdef O_DIRECT
+  if (direct_io_) {
+    db_fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (db_fd_ >= 0) {
+      return;
     }
+    // tmpfs and a few other file systems reject O_DIRECT; buffered I/O still works there.
+    LOG_WARN("O_DIRECT is not supported for %s, using buffered I/O", file_name_.c_str());
   }
-  buffer_used = nullptr;
+#endif
+  direct_io_ = false;
+  db_fd_ = OpenFile(file_name_, 0);
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  {
+    std::lock_guard<std::mutex> guard(extent_allocators_latch_);
+    for (ExtentAllocator *allocator : extent_allocators_) {
+      allocator->Detach();
+    }
+    extent_allocators_.clear();
+  }
+  io_engine_->Drain();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
+  if (free_space_map_ != nullptr) {
+    free_space_map_->Close();
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
+  if (direct_io_ && !IsAligned(page_data)) {
+    char *buffer = AlignedBuffer();
+    memcpy(buffer, page_data, PAGE_SIZE);
+    page_data = buffer;
+  }
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  num_write_calls_ += 1;
   // check for I/O error
-  if (db_io_.bad()) {
+  if (!WriteFully(db_fd_, page_data, PAGE_SIZE, offset)) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  if (sync_policy_ == SyncPolicy::ALWAYS) {
+    fdatasync(db_fd_);
+  }
+  // grow the cached file size; concurrent writers may race, so only ever move it forward
+  int64_t size = db_file_size_;
+  while (size < offset + PAGE_SIZE && !db_file_size_.compare_exchange_weak(size, offset + PAGE_SIZE)) {
+  }
+}
+
+void DiskManager::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  // A page that O_DIRECT cannot take as it is goes through the bounce buffer on its own.
+  for (const char *page_data : pages) {
+    if (direct_io_ && !IsAligned(page_data)) {
+      for (size_t i = 0; i < pages.size(); ++i) {
+        WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+      }
+      return;
+    }
+  }
+
+  std::vector<struct iovec> iov(pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    iov[i].iov_base = const_cast<char *>(pages[i]);
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  const auto max_iov = static_cast<size_t>(sysconf(_SC_IOV_MAX));
+  for (size_t begin = 0; begin < pages.size(); begin += max_iov) {
+    const size_t count = std::min(max_iov, pages.size() - begin);
+    const int64_t offset = static_cast<int64_t>(first_page_id + begin) * PAGE_SIZE;
+    num_writes_ += count;
+    num_write_calls_ += 1;
+    if (!WriteVectorFully(db_fd_, iov.data() + begin, count, offset)) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+  }
+  const int64_t end = static_cast<int64_t>(first_page_id + pages.size()) * PAGE_SIZE;
+  int64_t size = db_file_size_;
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+void DiskManager::Sync() {
+  if (sync_policy_ != SyncPolicy::NONE) {
+    fdatasync(db_fd_);
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset >= db_file_size_) {
     LOG_DEBUG("I/O error reading past end of file, page id: %d", page_id);
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  char *buffer = direct_io_ && !IsAligned(page_data) ? AlignedBuffer() : page_data;
+  ssize_t read_count = ReadFully(db_fd_, buffer, PAGE_SIZE, offset);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(buffer + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, PAGE_SIZE);
+  }
+}
+
+/**
+ * Queue a write of the specified page; the cached file size grows once the write is done, and the page cannot be
+ * deallocated before its callback has returned
+ */
+void DiskManager::WritePageAsync(page_id_t page_id, const char *page_data, IOCallback callback) {
+  const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
+  // O_DIRECT needs an aligned buffer that lives until the write is done.
+  std::shared_ptr<char> bounce;
+  if (direct_io_ && !IsAligned(page_data)) {
+    bounce.reset(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)), free);
+    memcpy(bounce.get(), page_data, PAGE_SIZE);
+    page_data = bounce.get();
+  }
+  num_writes_ += 1;
+  {
+    std::lock_guard<std::mutex> guard(pending_writes_latch_);
+    ++pending_writes_[page_id];
+  }
+  io_engine_->Submit({IORequest::Type::WRITE, db_fd_, const_cast<char *>(page_data), PAGE_SIZE, offset,
+                      [this, page_id, offset, bounce, callback = std::move(callback)](int64_t result) {
+                        const bool ok = result == PAGE_SIZE;
+                        if (!ok) {
+                          LOG_DEBUG("I/O error while writing page %d", page_id);
+                        } else {
+                          if (sync_policy_ == SyncPolicy::ALWAYS) {
+                            fdatasync(db_fd_);
+                          }
+                          int64_t size = db_file_size_;
+                          while (size < offset + PAGE_SIZE &&
+                                 !db_file_size_.compare_exchange_weak(size, offset + PAGE_SIZE)) {
+                          }
+                        }
+                        callback(ok);
+                        {
+                          std::lock_guard<std::mutex> guard(pending_writes_latch_);
+                          if (--pending_writes_[page_id] == 0) {
+                            pending_writes_.erase(page_id);
+                          }
+                        }
+                        pending_writes_done_.notify_all();
+                      }});
+}
+
+/**
+ * Queue a read of the specified page; reads past the end of the file complete right away with a zeroed page
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data, IOCallback callback) {
+  std::vector<IOCallback> callbacks;
+  callbacks.push_back(std::move(callback));
+  ReadPagesAsync({page_id}, {page_data}, std::move(callbacks));
+}
+
+void DiskManager::ReadPagesAsync(const std::vector<page_id_t> &page_ids, const std::vector<char *> &pages,
+                                 std::vector<IOCallback> callbacks) {
+  std::vector<IORequest> requests;
+  requests.reserve(page_ids.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    const page_id_t page_id = page_ids[i];
+    char *page_data = pages[i];
+    const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
+    if (offset >= db_file_size_) {
+      LOG_DEBUG("I/O error reading past end of file, page id: %d", page_id);
+      memset(page_data, 0, PAGE_SIZE);
+      callbacks[i](true);
+      continue;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    std::shared_ptr<char> bounce;
+    char *buffer = page_data;
+    if (direct_io_ && !IsAligned(page_data)) {
+      bounce.reset(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)), free);
+      buffer = bounce.get();
     }
+    requests.push_back({IORequest::Type::READ, db_fd_, buffer, PAGE_SIZE, offset,
+                        [page_id, page_data, buffer, bounce, callback = std::move(callbacks[i])](int64_t result) {
+                          if (result < 0) {
+                            LOG_DEBUG("I/O error while reading page %d", page_id);
+                            callback(false);
+                            return;
+                          }
+                          // if file ends before reading PAGE_SIZE
+                          memset(buffer + result, 0, PAGE_SIZE - result);
+                          if (buffer != page_data) {
+                            memcpy(page_data, buffer, PAGE_SIZE);
+                          }
+                          callback(true);
+                        }});
+  }
+  if (!requests.empty()) {
+    io_engine_->SubmitBatch(std::move(requests));
   }
 }
 
@@ -143,16 +404,17 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
+  // sequence write through the I/O engine; the log file is opened with O_APPEND, so the offset is ignored
+  std::promise<int64_t> written;
+  io_engine_->Submit({IORequest::Type::WRITE, log_fd_, log_data, static_cast<size_t>(size), 0,
+                      [&written](int64_t result) { written.set_value(result); }});
+  if (written.get_future().get() != size) {
     LOG_DEBUG("I/O error while writing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  if (sync_policy_ == SyncPolicy::ALWAYS) {
+    fdatasync(log_fd_);
+  }
   flush_log_ = false;
 }
 
@@ -167,17 +429,13 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  ssize_t read_count = ReadFully(log_fd_, log_data, size, offset);
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
@@ -186,16 +444,53 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Freed pages are handed out first, lowest page id first, so the file only grows when it is full
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() { return free_space_map_->Allocate(); }
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page is marked free in the free space map; its contents stay on disk until the page is reused
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  WaitForPendingWrites(page_id, 1);
+  free_space_map_->Deallocate(page_id);
+}
+
+/**
+ * Allocate a run of pages, placed in the lowest hole of the file that is large enough
+ */
+page_id_t DiskManager::AllocateExtent(size_t num_pages) { return free_space_map_->Allocate(num_pages); }
+
+/**
+ * Deallocate a run of pages
+ */
+void DiskManager::DeallocateExtent(page_id_t first_page_id, size_t num_pages) {
+  WaitForPendingWrites(first_page_id, num_pages);
+  free_space_map_->Deallocate(first_page_id, num_pages);
+}
+
+void DiskManager::WaitForPendingWrites(page_id_t first_page_id, size_t num_pages) {
+  const auto end = first_page_id + static_cast<page_id_t>(num_pages);
+  std::unique_lock<std::mutex> lock(pending_writes_latch_);
+  pending_writes_done_.wait(lock, [&] {
+    return std::none_of(pending_writes_.begin(), pending_writes_.end(),
+                        [&](const auto &entry) { return entry.first >= first_page_id && entry.first < end; });
+  });
+}
+
+void DiskManager::RegisterExtentAllocator(ExtentAllocator *allocator) {
+  std::lock_guard<std::mutex> guard(extent_allocators_latch_);
+  extent_allocators_.insert(allocator);
+}
+
+void DiskManager::UnregisterExtentAllocator(ExtentAllocator *allocator) {
+  std::lock_guard<std::mutex> guard(extent_allocators_latch_);
+  // ShutDown() may have detached the allocator already.
+  if (extent_allocators_.erase(allocator) != 0) {
+    allocator->Detach();
+  }
+}
 
 /**
  * Returns number of flushes made so far
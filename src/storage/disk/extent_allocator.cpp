@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.cpp
+//
+// Identification: src/storage/disk/extent_allocator.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/extent_allocator.h"
+
+namespace bustub {
+
+ExtentAllocator::ExtentAllocator(DiskManager *disk_manager, size_t extent_size)
+    : disk_manager_(disk_manager), extent_size_(extent_size) {
+  BUSTUB_ASSERT(extent_size_ > 0, "An extent needs at least one page.");
+  disk_manager_->RegisterExtentAllocator(this);
+}
+
+ExtentAllocator::~ExtentAllocator() {
+  DiskManager *disk_manager;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    disk_manager = disk_manager_;
+  }
+  if (disk_manager != nullptr) {
+    disk_manager->UnregisterExtentAllocator(this);
+  }
+}
+
+void ExtentAllocator::Detach() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (next_page_id_ != extent_end_) {
+    disk_manager_->DeallocateExtent(next_page_id_, extent_end_ - next_page_id_);
+  }
+  next_page_id_ = extent_end_ = INVALID_PAGE_ID;
+  disk_manager_ = nullptr;
+}
+
+page_id_t ExtentAllocator::AllocatePage() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (disk_manager_ == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  if (next_page_id_ == extent_end_) {
+    next_page_id_ = disk_manager_->AllocateExtent(extent_size_);
+    extent_end_ = next_page_id_ + static_cast<page_id_t>(extent_size_);
+  }
+  return next_page_id_++;
+}
+
+void ExtentAllocator::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  // The page handed out last goes back into the extent, anything else back to the disk manager.
+  if (page_id + 1 == next_page_id_) {
+    --next_page_id_;
+    return;
+  }
+  if (disk_manager_ != nullptr) {
+    disk_manager_->DeallocatePage(page_id);
+  }
+}
+
+}  // namespace bustub
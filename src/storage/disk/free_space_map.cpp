@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(const std::string &file_name, page_id_t num_db_pages, bool sync)
+    : file_name_(file_name), sync_(sync) {
+  fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw Exception("can't open " + file_name_ + ": " + strerror(errno));
+  }
+
+  // An empty database file is a new database, whatever an old map file next to it says.
+  struct stat stat_buf;
+  if (num_db_pages == 0 || fstat(fd_, &stat_buf) != 0 || stat_buf.st_size == 0) {
+    if (ftruncate(fd_, 0) != 0) {
+      LOG_WARN("can't truncate %s: %s", file_name_.c_str(), strerror(errno));
+    }
+    // A database file written before there were maps: everything it holds is in use.
+    std::lock_guard<std::mutex> guard(latch_);
+    for (page_id_t page_id = 0; page_id < num_db_pages; ++page_id) {
+      SetBit(page_id, true);
+    }
+    for (page_id_t page_id = 0; page_id < num_db_pages; page_id += BITS_PER_PAGE) {
+      WriteMapPage(page_id);
+    }
+    next_page_id_ = first_free_hint_ = num_db_pages;
+    return;
+  }
+
+  const size_t num_map_pages = (stat_buf.st_size + PAGE_SIZE - 1) / PAGE_SIZE;
+  bitmap_.resize(num_map_pages * WORDS_PER_PAGE);
+  auto *data = reinterpret_cast<char *>(bitmap_.data());
+  const size_t size = bitmap_.size() * sizeof(uint64_t);
+  for (size_t done = 0; done < size;) {
+    ssize_t n = pread(fd_, data + done, size - done, done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    done += n;
+  }
+
+  // Pages freed at the end of the database file are still part of it, so the file size bounds the page ids too.
+  next_page_id_ = num_db_pages;
+  for (size_t word = bitmap_.size(); word > 0; --word) {
+    if (bitmap_[word - 1] != 0) {
+      const auto highest = static_cast<page_id_t>((word - 1) * 64 + 63 - __builtin_clzll(bitmap_[word - 1]));
+      next_page_id_ = std::max(next_page_id_, highest + 1);
+      break;
+    }
+  }
+  const size_t num_words = (next_page_id_ + BITS_PER_PAGE - 1) / BITS_PER_PAGE * WORDS_PER_PAGE;
+  bitmap_.resize(std::max(bitmap_.size(), num_words));
+  first_free_hint_ = next_page_id_;
+  for (page_id_t page_id = next_page_id_ - 1; page_id >= 0; --page_id) {
+    if (!IsAllocatedLocked(page_id)) {
+      ++num_free_pages_;
+      first_free_hint_ = page_id;
+    }
+  }
+}
+
+FreeSpaceMap::~FreeSpaceMap() { Close(); }
+
+void FreeSpaceMap::Close() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+page_id_t FreeSpaceMap::Allocate(size_t count) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (count > 1) {
+    const page_id_t first = FindFreeRun(count);
+    const page_id_t end = first + static_cast<page_id_t>(count);
+    for (page_id_t page_id = first; page_id < end; ++page_id) {
+      if (page_id < next_page_id_) {
+        --num_free_pages_;
+      }
+      SetBit(page_id, true);
+    }
+    next_page_id_ = std::max(next_page_id_, end);
+    if (first_free_hint_ == first) {
+      first_free_hint_ = end;
+    }
+    WriteMapPages(first, count);
+    return first;
+  }
+
+  page_id_t page_id = next_page_id_;
+  if (num_free_pages_ > 0) {
+    // Skip whole words of allocated pages; there is a free page before next_page_id_.
+    size_t word = first_free_hint_ / 64;
+    while (bitmap_[word] == ~uint64_t{0}) {
+      ++word;
+    }
+    page_id = static_cast<page_id_t>(word * 64 + __builtin_ctzll(~bitmap_[word]));
+    --num_free_pages_;
+    first_free_hint_ = page_id + 1;
+  } else {
+    first_free_hint_ = ++next_page_id_;
+  }
+  SetBit(page_id, true);
+  WriteMapPage(page_id);
+  return page_id;
+}
+
+void FreeSpaceMap::Deallocate(page_id_t page_id, size_t count) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (page_id < 0 || count == 0) {
+    return;
+  }
+  bool changed = false;
+  for (page_id_t free_page_id = page_id; free_page_id < page_id + static_cast<page_id_t>(count); ++free_page_id) {
+    if (IsAllocatedLocked(free_page_id)) {
+      SetBit(free_page_id, false);
+      ++num_free_pages_;
+      first_free_hint_ = std::min(first_free_hint_, free_page_id);
+      changed = true;
+    }
+  }
+  if (changed) {
+    WriteMapPages(page_id, count);
+  }
+}
+
+bool FreeSpaceMap::IsAllocated(page_id_t page_id) const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return page_id >= 0 && IsAllocatedLocked(page_id);
+}
+
+page_id_t FreeSpaceMap::GetNextPageId() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return next_page_id_;
+}
+
+size_t FreeSpaceMap::GetNumFreePages() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_free_pages_;
+}
+
+page_id_t FreeSpaceMap::FindFreeRun(size_t count) const {
+  // Every page id below first_free_hint_ is allocated. A run still open at next_page_id_ continues into the unused
+  // page ids past the end.
+  page_id_t run_start = first_free_hint_;
+  page_id_t page_id = first_free_hint_;
+  while (page_id < next_page_id_ && static_cast<size_t>(page_id - run_start) < count) {
+    if (page_id % 64 == 0 && bitmap_[page_id / 64] == ~uint64_t{0}) {
+      page_id += 64;
+      run_start = page_id;
+    } else if (IsAllocatedLocked(page_id++)) {
+      run_start = page_id;
+    }
+  }
+  return std::min(run_start, next_page_id_);
+}
+
+void FreeSpaceMap::SetBit(page_id_t page_id, bool allocated) {
+  const size_t word = page_id / 64;
+  if (word >= bitmap_.size()) {
+    bitmap_.resize((word / WORDS_PER_PAGE + 1) * WORDS_PER_PAGE);
+  }
+  const uint64_t mask = uint64_t{1} << (page_id % 64);
+  bitmap_[word] = allocated ? bitmap_[word] | mask : bitmap_[word] & ~mask;
+}
+
+void FreeSpaceMap::WriteMapPage(page_id_t page_id) {
+  if (fd_ < 0) {
+    return;
+  }
+  const size_t map_page = page_id / BITS_PER_PAGE;
+  const char *data = reinterpret_cast<const char *>(bitmap_.data() + map_page * WORDS_PER_PAGE);
+  const off_t offset = static_cast<off_t>(map_page) * PAGE_SIZE;
+  for (size_t done = 0; done < PAGE_SIZE;) {
+    ssize_t n = pwrite(fd_, data + done, PAGE_SIZE - done, offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing the free space map");
+      return;
+    }
+    done += n;
+  }
+  if (sync_) {
+    fdatasync(fd_);
+  }
+}
+
+}  // namespace bustub
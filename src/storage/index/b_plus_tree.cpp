@@ -9,7 +9,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <numeric>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -20,13 +25,16 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, BufferPoolManager *header_buffer_pool_manager)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
+      header_buffer_pool_manager_(header_buffer_pool_manager != nullptr ? header_buffer_pool_manager
+                                                                        : buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      extent_allocator_(buffer_pool_manager->GetExtentAllocator()) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -35,11 +43,32 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
 
 INDEX_TEMPLATE_ARGUMENTS
-BPlusTreePage *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
-  const auto page = buffer_pool_manager_->FetchPage(page_id);
-  assert(page != nullptr);
-  return reinterpret_cast<BPlusTreePage *>(page->GetData());
+ReadPageGuard BPLUSTREE_TYPE::FetchPageRead(page_id_t page_id) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for B+ tree page");
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FetchPageWrite(page_id_t page_id) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for B+ tree page");
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::NewPage(page_id_t *page_id) {
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id, extent_allocator_.get()).UpgradeWrite();
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for new B+ tree page");
+  }
+  return guard;
 }
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -50,151 +79,259 @@ BPlusTreePage *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  // 1. find page
-  auto leaf_page = FindLeafPage(key);
-  if (!leaf_page) {
+  ReadPageGuard guard = FindLeafPage(key);
+  if (!guard.IsValid()) {
     return false;
   }
-  // 2. find value
-  result->resize(1);
-  const bool exist = leaf_page->Lookup(key, &result->at(0), comparator_);
-  // 3. unpin buffer page
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-  return exist;
+  ValueType value;
+  if (!guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
+    return false;
+  }
+  result->push_back(value);
+  return true;
+}
+
+/*
+ * Look up many keys in one go. The keys are visited in order, and a leaf stays
+ * read-latched while the next key still lies below its high key; a key beyond
+ * it most likely is in the right sibling, which is reached through the link
+ * instead of another descent from the root.
+ * @return : the number of keys that exist
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<ValueType> *result,
+                                 std::vector<bool> *found, Transaction *transaction) {
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  auto key_less = [&](size_t a, size_t b) { return comparator_(keys[a], keys[b]) < 0; };
+  if (!std::is_sorted(order.begin(), order.end(), key_less)) {
+    std::sort(order.begin(), order.end(), key_less);
+  }
+  result->assign(keys.size(), ValueType());
+  found->assign(keys.size(), false);
+
+  size_t found_count = 0;
+  ReadPageGuard guard;
+  for (const size_t index : order) {
+    const KeyType &key = keys[index];
+    if (guard.IsValid() && RightSibling(guard.As<BPlusTreePage>(), key) != INVALID_PAGE_ID) {
+      guard = FetchPageRead(guard.As<LeafPage>()->GetNextPageId());
+      if (RightSibling(guard.As<BPlusTreePage>(), key) != INVALID_PAGE_ID) {
+        guard.Drop();
+      }
+    }
+    if (!guard.IsValid()) {
+      guard = FindLeafPage(key);
+      if (!guard.IsValid()) {
+        break;
+      }
+    }
+    ValueType value;
+    if (guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
+      (*result)[index] = value;
+      (*found)[index] = true;
+      ++found_count;
+    }
+  }
+  return found_count;
 }
-// std::ofstream out("out.txt", std::ios::out | std::ios::trunc);
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
- * entry, otherise insert into leaf page.
+ * entry, otherwise insert into leaf page. Only the leaf is write-latched.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  // if current tree is empty, start new tree, update root page id and insert entry
+  Context context;
+  structure_latch_.RLock();
+  context.structure_latch_ = &structure_latch_;
+  if (StartNewTreeIfEmpty(key, value, &context)) {
+    return true;
+  }
+  WritePageGuard leaf_guard = FindPageWrite(key, 0, &context);
+  return InsertIntoLeaf(&leaf_guard, key, value, &context);
+}
 
-  bool inserted = true;
-  if (IsEmpty()) {
-    StartNewTree(key, value);
-  } else {
-    inserted = InsertIntoLeaf(key, value, transaction);
+/*
+ * Insert many key & value pairs in one go. The entries are inserted in key
+ * order, and a leaf stays write-latched while the next key still lies below
+ * its high key, so that a run of keys going into the same leaf takes a single
+ * descent. A split ends the run: the next key descends again.
+ * @return: the number of pairs inserted; duplicate keys are not
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::InsertBatch(std::vector<std::pair<KeyType, ValueType>> *entries, Transaction *transaction) {
+  auto key_less = [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; };
+  if (!std::is_sorted(entries->begin(), entries->end(), key_less)) {
+    std::stable_sort(entries->begin(), entries->end(), key_less);
+  }
+
+  size_t inserted = 0;
+  Context context;
+  structure_latch_.RLock();
+  context.structure_latch_ = &structure_latch_;
+  WritePageGuard leaf_guard;
+  for (const auto &[key, value] : *entries) {
+    if (leaf_guard.IsValid() && RightSibling(leaf_guard.As<BPlusTreePage>(), key) != INVALID_PAGE_ID) {
+      leaf_guard.Drop();
+    }
+    if (!leaf_guard.IsValid()) {
+      if (StartNewTreeIfEmpty(key, value, &context)) {
+        context.ReleaseRootLatch();
+        ++inserted;
+        continue;
+      }
+      leaf_guard = FindPageWrite(key, 0, &context);
+    }
+    if (InsertIntoLeaf(&leaf_guard, key, value, &context)) {
+      ++inserted;
+    }
   }
   return inserted;
 }
+
 /*
- * Insert constant key & value pair into an empty tree
- * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then update b+
- * tree's root page id and insert entry directly into leaf page.
+ * Start a new tree with key & value pair if the tree is empty. The root latch
+ * stays held in the context if it did.
+ * @return: true if the tree was empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-  // 1. Allocate a new page from bufer pool manager
-  // page_id_t root_page_id;
-  Page *root_page = buffer_pool_manager_->NewPage(&root_page_id_);
-  assert(root_page != nullptr);
-  LOG_DEBUG("root page id: %d", root_page_id_);
-  // B_PLUS_TREE_LEAF_PAGE
-  auto root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(root_page->GetData());
-  // 2. Update B+ tree root page id.
-  root->Init(root_page_id_, INVALID_PAGE_ID);
-  // 3. Insert a new entry into leaf page.
-  root->Insert(key, value, comparator_);
-  UpdateRootPageId(true);
-  buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
+bool BPLUSTREE_TYPE::StartNewTreeIfEmpty(const KeyType &key, const ValueType &value, Context *context) {
+  if (!IsEmpty()) {
+    return false;
+  }
+  root_latch_.WLock();
+  context->root_latch_ = &root_latch_;
+  if (IsEmpty()) {
+    StartNewTree(key, value);
+    return true;
+  }
+  context->ReleaseRootLatch();
+  return false;
 }
 
 /*
- * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * Insert key & value pair into the write-latched leaf page that covers key. A
+ * leaf that overflows is split and released before the new page is linked
+ * into the parent, and the split goes up the path as far as parents overflow
+ * in turn, one page latched at a time.
+ * @return: false if the key exists already
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  auto leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(FindLeafPage(key));
-  ValueType _v;  // unused
-  const bool exist = leaf_page->Lookup(key, &_v, comparator_);
-  if (exist) {
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+bool BPLUSTREE_TYPE::InsertIntoLeaf(WritePageGuard *leaf_guard, const KeyType &key, const ValueType &value,
+                                    Context *context) {
+  ValueType existing;
+  if (leaf_guard->As<LeafPage>()->Lookup(key, &existing, comparator_)) {
     return false;
   }
-  leaf_page->Insert(key, value, comparator_);
-  LOG_DEBUG("Inserted page id: %d, size: %d max size: %d %d", leaf_page->GetPageId(), leaf_page->GetSize(),
-            leaf_page->GetMaxSize(), leaf_max_size_);
-  if (leaf_page->GetSize() > leaf_page->GetMaxSize()) {
-    auto new_leaf_page = Split(leaf_page);
-    InsertIntoParent(leaf_page, new_leaf_page->KeyAt(0), new_leaf_page, transaction);
+  auto *leaf = leaf_guard->AsMut<LeafPage>();
+  leaf->Insert(key, value, comparator_);
+  if (leaf->GetSize() > leaf->GetMaxSize()) {
+    KeyType middle_key;
+    const page_id_t new_page_id = Split(leaf, &middle_key);
+    const page_id_t page_id = leaf_guard->PageId();
+    leaf_guard->Drop();
+    InsertIntoParent(page_id, middle_key, new_page_id, 0, context);
   }
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
   return true;
 }
 
 /*
- * Split input page and return newly created page.
- * Using template N to represent either internal page or leaf page.
+ * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * an "out of memory" exception if returned value is nullptr), then update b+
+ * tree's root page id and insert entry directly into leaf page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t root_page_id;
+  WritePageGuard root_guard = NewPage(&root_page_id);
+  auto *root = root_guard.AsMut<LeafPage>();
+  root->Init(root_page_id, leaf_max_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(true);
+}
+
+/*
+ * Split input page and return the id of the newly created page, its new right
+ * sibling, which gets the upper half of the entries. The split page links to
+ * it and takes the first key of it as its high key, so that descents reach the
+ * new page through the split page until the parent links it.
+ * Using template N to represent either internal page or leaf page.
+ * @param[out] middle_key   the key separating the two pages in their parent
  */
-INDEX_TEMPLATE_ARGUMENTS template <typename N>
-N *BPLUSTREE_TYPE::Split(N *node) {
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+page_id_t BPLUSTREE_TYPE::Split(N *node, KeyType *middle_key) {
   page_id_t page_id;
-  Page *new_page = buffer_pool_manager_->NewPage(&page_id);
-  assert(new_page != nullptr);
-  auto new_node = reinterpret_cast<N *>(new_page->GetData());
-  new_node->Init(page_id, node->GetParentPageId());
-  new_node->MoveHalfTo(node, buffer_pool_manager_);
-  return node;
+  WritePageGuard new_guard = NewPage(&page_id);
+  auto *new_node = new_guard.AsMut<N>();
+  new_node->Init(page_id, node->GetMaxSize());
+  node->MoveHalfTo(new_node);
+  *middle_key = new_node->KeyAt(0);
+  return page_id;
 }
+
 /*
- * Insert key & value pair into internal page after split
- * @param   old_node      input page from split() method
- * @param   key
- * @param   new_node      returned page from split() method
- * User needs to first find the parent page of old_node, parent node must be
- * adjusted to take info of new_node into account. Remember to deal with split
- * recursively if necessary.
+ * Insert the separator of a split page on level and its new right sibling
+ * into the parent, on level + 1. The split page is no longer latched. The
+ * parent is the last page of the path, or a page right of it if the parent
+ * was split meanwhile. If the split page was the root when the insert came
+ * down, a new root is grown above it, unless another insert grew one first;
+ * then the parent is searched from the new root, once there is a root above
+ * level. Splits the parent in turn if it overflows.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {
-  if (old_node->IsRootPage()) {
-    page_id_t new_page_id;
-    Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
-    assert(new_page != nullptr);
-    assert(new_page->GetPinCount() == 1);
-
-    InternalPage *node = reinterpret_cast<InternalPage *>(new_page->GetData());
-    node->Init(root_page_id_, INVALID_PAGE_ID);
-    node->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-    old_node->SetParentPageId(root_page_id_);
-    new_node->SetParentPageId(root_page_id_);
-    UpdateRootPageId(false);
-    // Fetch page and new page need to unpin page
-    buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(old_node->GetPageId(), true);
-    return;
+void BPLUSTREE_TYPE::InsertIntoParent(page_id_t old_page_id, const KeyType &key, page_id_t new_page_id, int level,
+                                      Context *context) {
+  WritePageGuard parent_guard;
+  if (context->path_.empty()) {
+    while (true) {
+      root_latch_.WLock();
+      context->root_latch_ = &root_latch_;
+      if (root_page_id_ == old_page_id) {
+        page_id_t root_page_id;
+        WritePageGuard root_guard = NewPage(&root_page_id);
+        auto *root = root_guard.AsMut<InternalPage>();
+        root->Init(root_page_id, internal_max_size_);
+        root->SetLevel(level + 1);
+        root->PopulateNewRoot(old_page_id, key, new_page_id);
+        root_page_id_ = root_page_id;
+        UpdateRootPageId();
+        context->ReleaseRootLatch();
+        return;
+      }
+      const int root_level = FetchPageRead(root_page_id_).template As<BPlusTreePage>()->GetLevel();
+      context->ReleaseRootLatch();
+      if (root_level > level) {
+        break;
+      }
+      // The root is still a page on this level: the insert that split it has not grown the new root yet.
+      std::this_thread::yield();
+    }
+    parent_guard = FindPageWrite(key, level + 1, context);
+  } else {
+    parent_guard = FetchPageWrite(context->path_.back());
+    context->path_.pop_back();
+    MoveRight(key, &parent_guard);
   }
-  const page_id_t parent_id = old_node->GetParentPageId();
-  auto parent_page = FetchPage(parent_id);
-  assert(parent_page != nullptr);
-  auto parent_node = reinterpret_cast<InternalPage *>(parent_page);
-  new_node->SetParentPageId(parent_id);
-  buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
 
-  parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-  if (parent_node->GetSize() > parent_node->GetMaxSize()) {
-    InternalPage *new_leaf_page = Split(parent_node);
-    InsertIntoParent(parent_node, new_leaf_page->KeyAt(0), new_leaf_page, transaction);
+  auto *parent = parent_guard.AsMut<InternalPage>();
+  parent->Insert(key, new_page_id, comparator_);
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    KeyType middle_key;
+    const page_id_t new_parent_id = Split(parent, &middle_key);
+    const page_id_t parent_id = parent_guard.PageId();
+    parent_guard.Drop();
+    InsertIntoParent(parent_id, middle_key, new_parent_id, level + 1, context);
   }
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
 }
 
 /*****************************************************************************
@@ -202,151 +339,257 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  *****************************************************************************/
 /*
  * Delete key & value pair associated with input key
- * If current tree is empty, return immdiately.
+ * If current tree is empty, return immediately.
  * If not, User needs to first find the right leaf page as deletion target, then
- * delete entry from leaf page. Remember to deal with redistribute or merge if
- * necessary.
+ * delete entry from leaf page. Like an insert, this only write-latches the
+ * leaf. If the leaf underflows, it is rebalanced afterwards.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  if (IsEmpty()) {
-    return;
-  }
-  auto leaf_page = FindLeafPage(key);
-  const int old_size = leaf_page->GetSize();
-  const int curr_size = leaf_page->RemoveAndDeleteRecord(key, comparator_);
-  const bool removed = old_size > curr_size;
-  ToString(leaf_page, buffer_pool_manager_);
-  const bool delete_page =
-      removed && curr_size < leaf_page->GetMinSize() && CoalesceOrRedistribute(leaf_page, transaction);
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), removed);
-  if (delete_page) {
-    LOG_DEBUG("Start to delete Page");
-    buffer_pool_manager_->DeletePage(leaf_page->GetPageId());
+  {
+    Context context;
+    structure_latch_.RLock();
+    context.structure_latch_ = &structure_latch_;
+    if (IsEmpty()) {
+      return;
+    }
+    WritePageGuard leaf_guard = FindPageWrite(key, 0, &context);
+    ValueType existing;
+    if (!leaf_guard.As<LeafPage>()->Lookup(key, &existing, comparator_)) {
+      return;
+    }
+    auto *leaf = leaf_guard.AsMut<LeafPage>();
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    // The latched leaf cannot become the root or stop being it: that takes a split of it.
+    const bool is_root = leaf_guard.PageId() == root_page_id_;
+    if (is_root ? leaf->GetSize() > 0 : leaf->GetSize() >= leaf->GetMinSize()) {
+      return;
+    }
   }
+  Rebalance(key);
 }
 
 /*
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
- * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
+ * Merge or redistribute the leaf page covering key if it is still too small,
+ * and its ancestors in turn. This holds the structure latch exclusively, so no
+ * split is under way and every parent links all of its children; the path is
+ * write-latched from the root down, keeping no more of it than the merges may
+ * change.
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  if (node->IsRootPage()) {
-    return AdjustRoot(node);
+void BPLUSTREE_TYPE::Rebalance(const KeyType &key) {
+  Context context;
+  structure_latch_.WLock();
+  context.structure_latch_ = &structure_latch_;
+  context.structure_exclusive_ = true;
+  root_latch_.WLock();
+  context.root_latch_ = &root_latch_;
+  if (IsEmpty()) {
+    return;
   }
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-
-  auto parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-  const int node_index = parent_node->ValueIndex(node->GetPageId());
-
-  const int sibling_index = node_index == 0 ? 1 : node_index - 1;
-  page_id_t sibling_page_id = parent_node->ValueAt(sibling_index);
-  Page *sibling_page = buffer_pool_manager_->FetchPage(sibling_page_id);
-  auto sibling_node = reinterpret_cast<N *>(sibling_page);
-  const bool coalesce = sibling_node->GetSize() + node->GetSize() < node->GetMaxSize();
-
-  bool removed_parent = false;
-  if (coalesce) {
-    removed_parent = Coalesce(sibling_node, node, parent_node, node_index, transaction);
-    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
-    if (node_index == 0) {
-      buffer_pool_manager_->DeletePage(sibling_node->GetPageId());
+  FindLeafPageWrite(key, &context);
+  const auto *leaf = context.write_set_.back().template As<LeafPage>();
+  if (context.write_set_.size() == 1) {
+    // Either the leaf is safe, or it is the root, which may shrink down to a single entry; after that, the tree is
+    // empty.
+    if (context.HoldsRoot() && leaf->GetSize() == 0) {
+      AdjustRoot(&context);
     }
-  } else {
-    Redistribute(sibling_node, node, node_index);
-    buffer_pool_manager_->UnpinPage(sibling_node->GetPageId(), true);
+    return;
   }
-
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
-  if (removed_parent) {
-    buffer_pool_manager_->DeletePage(parent_node->GetPageId());
+  if (leaf->GetSize() < leaf->GetMinSize()) {
+    CoalesceOrRedistribute<LeafPage>(&context);
   }
-
-  return coalesce && node_index != 0;
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
+ * The last page of the write set has underflowed. Find its sibling, the page
+ * left of it or, for the leftmost child, the page right of it. If the two fit
+ * into one page, merge the right one into the left one and delete it, which
+ * may make the parent underflow in turn. Otherwise, move one entry over from
+ * the sibling.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion
- * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::Coalesce(N *&neighbor_node, N *&node,
-                              BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent, int index,
-                              Transaction *transaction) {
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(Context *context) {
+  WritePageGuard node_guard = std::move(context->write_set_.back());
+  context->write_set_.pop_back();
+  auto *parent = context->write_set_.back().template AsMut<InternalPage>();
+  const int index = parent->ValueIndex(node_guard.PageId());
+  const int sibling_index = index == 0 ? 1 : index - 1;
+  WritePageGuard sibling_guard;
   if (index == 0) {
-    std::swap(node, neighbor_node);
-    index = 1;
+    sibling_guard = FetchPageWrite(parent->ValueAt(sibling_index));
+  } else {
+    // Siblings are latched left to right, the way iterators walk the leaf chain. Nothing else can change the node in
+    // between: every other modification has to come through the parent, which stays latched.
+    const page_id_t page_id = node_guard.PageId();
+    node_guard.Drop();
+    sibling_guard = FetchPageWrite(parent->ValueAt(sibling_index));
+    node_guard = FetchPageWrite(page_id);
   }
-  node->MoveAllTo(neighbor_node, neighbor_node->KeyAt(index), buffer_pool_manager_);
-
-  parent->Remove(index);
-  if (parent->GetSize() <= parent->GetMinSize()) {
-    return CoalesceOrRedistribute(parent, transaction);
+  auto *node = node_guard.AsMut<N>();
+  auto *sibling = sibling_guard.AsMut<N>();
+
+  if (node->GetSize() + sibling->GetSize() > node->GetMaxSize()) {
+    // Redistribute: the sibling has more than enough entries to spare one.
+    if (index == 0) {
+      if constexpr (std::is_same_v<N, LeafPage>) {
+        sibling->MoveFirstToEndOf(node);
+      } else {
+        sibling->MoveFirstToEndOf(node, parent->KeyAt(1));
+      }
+      parent->SetKeyAt(1, sibling->KeyAt(0));
+    } else {
+      if constexpr (std::is_same_v<N, LeafPage>) {
+        sibling->MoveLastToFrontOf(node);
+      } else {
+        sibling->MoveLastToFrontOf(node, parent->KeyAt(index));
+      }
+      parent->SetKeyAt(index, node->KeyAt(0));
+    }
+    return;
   }
 
-  return false;
-}
-
-/*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
- * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- */
-INDEX_TEMPLATE_ARGUMENTS
-template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
-  if (index == 0) {
-    neighbor_node->MoveFirstToEndOf(node, node->KeyAt(0), buffer_pool_manager_);
+  // Coalesce: the right page of the two goes into the left one.
+  const int right_index = index == 0 ? 1 : index;
+  WritePageGuard &left_guard = index == 0 ? node_guard : sibling_guard;
+  WritePageGuard &right_guard = index == 0 ? sibling_guard : node_guard;
+  auto *left = left_guard.AsMut<N>();
+  auto *right = right_guard.AsMut<N>();
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    right->MoveAllTo(left);
   } else {
-    neighbor_node->MoveLastToFrontOf(node, node->KeyAt(index), buffer_pool_manager_);
+    right->MoveAllTo(left, parent->KeyAt(right_index));
+  }
+  parent->Remove(right_index);
+  const page_id_t right_page_id = right_guard.PageId();
+  right_guard.Drop();
+  left_guard.Drop();
+  buffer_pool_manager_->DeletePage(right_page_id);
+
+  if (context->write_set_.size() == 1) {
+    if (context->HoldsRoot() && parent->GetSize() == 1) {
+      AdjustRoot(context);
+    }
+    return;
+  }
+  if (parent->GetSize() < parent->GetMinSize()) {
+    CoalesceOrRedistribute<InternalPage>(context);
   }
 }
+
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
- * called within coalesceOrRedistribute() method
+ * called for a root, the only page left in the write set, that became too small
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
- * @return : true means root page should be deleted, false means no deletion
- * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
+void BPLUSTREE_TYPE::AdjustRoot(Context *context) {
+  WritePageGuard root_guard = std::move(context->write_set_.back());
+  context->write_set_.pop_back();
+  const page_id_t old_root_page_id = root_guard.PageId();
+  if (root_guard.As<BPlusTreePage>()->IsLeafPage()) {
     root_page_id_ = INVALID_PAGE_ID;
-    UpdateRootPageId(false);
-    return true;
+  } else {
+    root_page_id_ = root_guard.AsMut<InternalPage>()->RemoveAndReturnOnlyChild();
+  }
+  UpdateRootPageId();
+  root_guard.Drop();
+  buffer_pool_manager_->DeletePage(old_root_page_id);
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build the tree bottom-up from entries instead of inserting them one by one:
+ * pack the sorted entries into leaves, then the first keys of the leaves into
+ * the internal pages above them, one level after the other, until a level
+ * fits into a single page, the root. No page is split, and every page is
+ * written once.
+ * @return: false if the tree is not empty, true otherwise
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries, double fill_factor) {
+  auto key_less = [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; };
+  auto key_equal = [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) == 0; };
+  if (!std::is_sorted(entries->begin(), entries->end(), key_less)) {
+    std::stable_sort(entries->begin(), entries->end(), key_less);
   }
-  if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
-    auto internal_page = reinterpret_cast<InternalPage *>(old_root_node);
-    auto new_root_id = internal_page->RemoveAndReturnOnlyChild();
-    auto new_root_page = buffer_pool_manager_->FetchPage(new_root_id);
-    auto new_root_node = reinterpret_cast<BPlusTreePage *>(new_root_page);
-    new_root_node->SetParentPageId(new_root_id);
-    root_page_id_ = new_root_id;
-    buffer_pool_manager_->UnpinPage(new_root_node->GetPageId(), true);
+  entries->erase(std::unique(entries->begin(), entries->end(), key_equal), entries->end());
+
+  Context context;
+  structure_latch_.WLock();
+  context.structure_latch_ = &structure_latch_;
+  context.structure_exclusive_ = true;
+  root_latch_.WLock();
+  context.root_latch_ = &root_latch_;
+  if (!IsEmpty()) {
+    return false;
+  }
+  if (entries->empty()) {
     return true;
   }
-  return false;
+
+  std::vector<std::pair<KeyType, page_id_t>> pages = BuildLevel<LeafPage>(*entries, 0, leaf_max_size_, fill_factor);
+  for (int level = 1; pages.size() > 1; ++level) {
+    pages = BuildLevel<InternalPage>(pages, level, internal_max_size_, fill_factor);
+  }
+  root_page_id_ = pages[0].second;
+  UpdateRootPageId(true);
+  return true;
+}
+
+/*
+ * Pack entries, sorted by key, into new pages of type N on level, linked left
+ * to right with their high keys set. Each page gets about fill_factor times
+ * max_size entries, never fewer than a page may have after a remove, and the
+ * entries are spread evenly so that the last page is not left short.
+ * Using template N to represent either internal page or leaf page.
+ * @return: the first key and the id of every page, the entries of the level
+ * above
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N, typename V>
+std::vector<std::pair<KeyType, page_id_t>> BPLUSTREE_TYPE::BuildLevel(const std::vector<std::pair<KeyType, V>> &entries,
+                                                                      int level, int max_size, double fill_factor) {
+  // the minimum sizes of BPlusTreePage::GetMinSize
+  const size_t min_size = std::max(level == 0 ? max_size / 2 : (max_size + 1) / 2, 1);
+  const size_t per_page =
+      std::clamp(static_cast<size_t>(max_size * fill_factor), min_size, static_cast<size_t>(max_size));
+  size_t page_count = (entries.size() + per_page - 1) / per_page;
+  while (page_count > 1 && entries.size() / page_count < min_size) {
+    --page_count;
+  }
+
+  std::vector<std::pair<KeyType, page_id_t>> pages;
+  pages.reserve(page_count);
+  WritePageGuard prev_guard;
+  for (size_t i = 0; i < page_count; ++i) {
+    const size_t begin = i * entries.size() / page_count;
+    const size_t end = (i + 1) * entries.size() / page_count;
+    page_id_t page_id;
+    WritePageGuard guard = NewPage(&page_id);
+    auto *page = guard.AsMut<N>();
+    page->Init(page_id, max_size);
+    page->SetLevel(level);
+    for (size_t j = begin; j < end; ++j) {
+      page->Insert(entries[j].first, entries[j].second, comparator_);
+    }
+    if (prev_guard.IsValid()) {
+      auto *prev = prev_guard.AsMut<N>();
+      prev->SetNextPageId(page_id);
+      prev->SetHighKey(entries[begin].first);
+    }
+    pages.emplace_back(entries[begin].first, page_id);
+    prev_guard = std::move(guard);
+  }
+  return pages;
 }
 
 /*****************************************************************************
@@ -359,9 +602,7 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
-  KeyType _key;  // holdplacer
-  auto first_page = FindLeafPage(_key, true);
-  return INDEXITERATOR_TYPE(first_page, 0, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, FindLeafPage(KeyType{}, true), 0);
 }
 
 /*
@@ -371,12 +612,9 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_node = FindLeafPage(key, true);
-  if (leaf_node == nullptr) {
-    LOG_DEBUG("Tree find first key is NULL");
-    return INDEXITERATOR_TYPE(nullptr, 0, buffer_pool_manager_);
-  }
-  return INDEXITERATOR_TYPE(leaf_node, leaf_node->KeyIndex(key, comparator_), buffer_pool_manager_);
+  ReadPageGuard guard = FindLeafPage(key);
+  const int index = guard.IsValid() ? guard.As<LeafPage>()->KeyIndex(key, comparator_) : 0;
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index);
 }
 
 /*
@@ -385,39 +623,207 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
-  auto leaf_node = FetchPage(root_page_id_);
-  int index = leaf_node->GetSize();
-  return INDEXITERATOR_TYPE(nullptr, index, buffer_pool_manager_);
-}
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() { return INDEXITERATOR_TYPE(buffer_pool_manager_, ReadPageGuard(), 0); }
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
- * the left most leaf page
+ * the left most leaf page. Lookups descend optimistically first, and fall
+ * back to latching their way down if they keep running into changes. There,
+ * every page on the way is read-latched only until its child is, and descents
+ * move right past pages that were split after their parent was read.
  */
 INDEX_TEMPLATE_ARGUMENTS
-B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  // NOTE: Leafmost is used for Interator location at beginning
-  // Find leaf page by next page_id in internel page node
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool left_most) {
+  for (int attempt = 0; !left_most && attempt < OPTIMISTIC_DESCENT_ATTEMPTS; ++attempt) {
+    ReadPageGuard guard;
+    if (FindLeafPageOptimistic(key, &guard)) {
+      return guard;
+    }
+  }
+
+  root_latch_.RLock();
   if (IsEmpty()) {
-    return nullptr;
-  }
-  auto page = FetchPage(root_page_id_);
-  //  LOG_DEBUG("page size: %d", page->GetSize());
-  page_id_t next;
-  for (auto cur = root_page_id_; !page->IsLeafPage(); cur = next, page = FetchPage(cur)) {
-    InternalPage *internal_page = static_cast<InternalPage *>(page);
-    if (leftMost) {
-      next = internal_page->ValueAt(0);
+    root_latch_.RUnlock();
+    return {};
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  root_latch_.RUnlock();
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for B+ tree page");
+  }
+  // The leftmost page of a level is never split away from, so the leftmost descent does not need to move right.
+  if (!left_most) {
+    MoveRight(key, &guard);
+  }
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    const auto *internal = guard.As<InternalPage>();
+    guard = FetchPageRead(left_most ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+    if (!left_most) {
+      MoveRight(key, &guard);
+    }
+  }
+  return guard;
+}
+
+/*
+ * Optimistic lock coupling: internal pages are neither pinned nor latched,
+ * only read optimistically. A page is validated once the id of its child, or
+ * of its right sibling if key lies beyond its high key, is read from it, and
+ * once more after the version of that page is taken, so that it was the right
+ * one at that version. Only the leaf is pinned and read-latched; if its
+ * version is still the same then, nothing moved any key in or out of it since.
+ * Pages that are not resident end the attempt, so that no stale page id is
+ * ever read from disk.
+ * @return false if the descent ran into a change and has to start over
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, ReadPageGuard *leaf_guard) {
+  page_id_t page_id = root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  const Page *parent = nullptr;
+  uint64_t parent_version = 0;
+  while (true) {
+    uint64_t version;
+    Page *page = buffer_pool_manager_->FetchPageOptimistic(page_id, &version);
+    if (page == nullptr) {
+      return false;
+    }
+    if (parent != nullptr ? !parent->ValidateOptimisticRead(parent_version) : root_page_id_ != page_id) {
+      return false;
+    }
+    const auto *node = reinterpret_cast<const BPlusTreePage *>(page->GetData());
+    page_id_t next_page_id = RightSibling(node, key);
+    const bool is_leaf = node->IsLeafPage();
+    if (next_page_id == INVALID_PAGE_ID && !is_leaf &&
+        !reinterpret_cast<const InternalPage *>(node)->LookupOptimistic(key, comparator_, &next_page_id)) {
+      return false;
+    }
+    if (!page->ValidateOptimisticRead(version)) {
+      return false;
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      Page *leaf = buffer_pool_manager_->FetchResidentPage(page_id);
+      if (leaf == nullptr) {
+        return false;
+      }
+      leaf->RLatch();
+      *leaf_guard = ReadPageGuard(buffer_pool_manager_, leaf);
+      return leaf == page && leaf->ValidateOptimisticRead(version);
+    }
+    parent = page;
+    parent_version = version;
+    page_id = next_page_id;
+  }
+}
+
+/*
+ * Write-latch the page on level that covers key. The way down read-latches
+ * one page at a time, moving right past pages that were split after their
+ * parent was read, and remembers the pages it took the child from in the path
+ * of the context. The caller holds the structure latch, so none of them is
+ * deleted meanwhile, and the tree is not empty.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FindPageWrite(const KeyType &key, int level, Context *context) {
+  context->path_.clear();
+  root_latch_.RLock();
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  root_latch_.RUnlock();
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for B+ tree page");
+  }
+  MoveRight(key, &guard);
+  BUSTUB_ASSERT(guard.As<BPlusTreePage>()->GetLevel() >= level, "the tree is lower than the level");
+  if (guard.As<BPlusTreePage>()->GetLevel() == level) {
+    // The root itself; latch it again, for writing. It may have been split in between.
+    const page_id_t page_id = guard.PageId();
+    guard.Drop();
+    WritePageGuard write_guard = FetchPageWrite(page_id);
+    MoveRight(key, &write_guard);
+    return write_guard;
+  }
+  while (true) {
+    const auto *internal = guard.As<InternalPage>();
+    const page_id_t child_page_id = internal->Lookup(key, comparator_);
+    context->path_.push_back(guard.PageId());
+    if (internal->GetLevel() == level + 1) {
+      WritePageGuard write_guard = FetchPageWrite(child_page_id);
+      guard.Drop();
+      MoveRight(key, &write_guard);
+      return write_guard;
+    }
+    guard = FetchPageRead(child_page_id);
+    MoveRight(key, &guard);
+  }
+}
+
+/*
+ * Write-latch the path from the root to the leaf page containing particular
+ * key, keeping it in the write set. The caller holds the root latch, and the
+ * structure latch exclusively. Every page that is safe releases the root latch
+ * and all pages above it, so that readers only queue up behind the part of the
+ * path the remove may actually change.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafPageWrite(const KeyType &key, Context *context) {
+  context->write_set_.push_back(FetchPageWrite(root_page_id_));
+  if (IsSafe(context->write_set_.back().template As<BPlusTreePage>(), true)) {
+    context->ReleaseAncestors();
+  }
+  while (!context->write_set_.back().template As<BPlusTreePage>()->IsLeafPage()) {
+    const auto *internal = context->write_set_.back().template As<InternalPage>();
+    context->write_set_.push_back(FetchPageWrite(internal->Lookup(key, comparator_)));
+    if (IsSafe(context->write_set_.back().template As<BPlusTreePage>(), false)) {
+      context->ReleaseAncestors();
+    }
+  }
+}
+
+/*
+ * A page is safe for a remove if one entry less does not make it underflow.
+ * The root has no minimum size, but shrinks the tree when its last child or
+ * last entry is gone.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *page, bool is_root) const {
+  if (is_root) {
+    return page->GetSize() > (page->IsLeafPage() ? 1 : 2);
+  }
+  return page->GetSize() > page->GetMinSize();
+}
+
+/*
+ * Move right from the latched page as long as key lies at or beyond its high
+ * key, i.e. the page was split and key went to a page its parent may not link
+ * yet. Pages are latched left to right, the next one before the current one is
+ * released.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Guard>
+void BPLUSTREE_TYPE::MoveRight(const KeyType &key, Guard *guard) {
+  page_id_t next_page_id;
+  while ((next_page_id = RightSibling(guard->template As<BPlusTreePage>(), key)) != INVALID_PAGE_ID) {
+    if constexpr (std::is_same_v<Guard, ReadPageGuard>) {
+      *guard = FetchPageRead(next_page_id);
     } else {
-      next = internal_page->Lookup(key, comparator_);
+      *guard = FetchPageWrite(next_page_id);
     }
-    buffer_pool_manager_->UnpinPage(cur, false);
   }
-  return static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::RightSibling(const BPlusTreePage *page, const KeyType &key) const {
+  if (page->IsLeafPage()) {
+    const auto *leaf = reinterpret_cast<const LeafPage *>(page);
+    return leaf->IsBeyondHighKey(key, comparator_) ? leaf->GetNextPageId() : INVALID_PAGE_ID;
+  }
+  const auto *internal = reinterpret_cast<const InternalPage *>(page);
+  return internal->IsBeyondHighKey(key, comparator_) ? internal->GetNextPageId() : INVALID_PAGE_ID;
 }
 
 /*
@@ -426,17 +832,18 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, boo
  * Call this method everytime root page id is changed.
  * @parameter: insert_record defualt value is false. When set to true,
  * insert a record <index_name, root_page_id> into header page instead of
- * updating it.
+ * updating it, unless the record already exists.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = reinterpret_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  WritePageGuard guard = header_buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for the header page");
+  }
+  auto *header_page = guard.AsPageMut<HeaderPage>();
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -472,6 +879,30 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name, Transaction *t
   }
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Print(BufferPoolManager *bpm) {
+  if (IsEmpty()) {
+    LOG_WARN("Print an empty tree");
+    return;
+  }
+  ReadPageGuard guard = bpm->FetchPageRead(root_page_id_);
+  ToString(guard.As<BPlusTreePage>(), bpm);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Draw(BufferPoolManager *bpm, const std::string &outf) {
+  if (IsEmpty()) {
+    LOG_WARN("Draw an empty tree");
+    return;
+  }
+  std::ofstream out(outf);
+  out << "digraph G {" << std::endl;
+  ReadPageGuard guard = bpm->FetchPageRead(root_page_id_);
+  ToGraph(guard.As<BPlusTreePage>(), bpm, out);
+  out << "}" << std::endl;
+  out.close();
+}
+
 /**
  * This method is used for debug only, You don't  need to modify
  * @tparam KeyType
@@ -482,11 +913,11 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name, Transaction *t
  * @param out
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const {
+void BPLUSTREE_TYPE::ToGraph(const BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const {
   std::string leaf_prefix("LEAF_");
   std::string internal_prefix("INT_");
   if (page->IsLeafPage()) {
-    auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page);
+    auto leaf = reinterpret_cast<const LeafPage *>(page);
     // Print node name
     out << leaf_prefix << leaf->GetPageId();
     // Print node properties
@@ -509,14 +940,8 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
       out << leaf_prefix << leaf->GetPageId() << " -> " << leaf_prefix << leaf->GetNextPageId() << ";\n";
       out << "{rank=same " << leaf_prefix << leaf->GetPageId() << " " << leaf_prefix << leaf->GetNextPageId() << "};\n";
     }
-
-    // Print parent links if there is a parent
-    if (leaf->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << leaf->GetParentPageId() << ":p" << leaf->GetPageId() << " -> " << leaf_prefix
-          << leaf->GetPageId() << ";\n";
-    }
   } else {
-    InternalPage *inner = reinterpret_cast<InternalPage *>(page);
+    auto inner = reinterpret_cast<const InternalPage *>(page);
     // Print node name
     out << internal_prefix << inner->GetPageId();
     // Print node properties
@@ -540,26 +965,20 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
     out << "</TR>";
     // Print table end
     out << "</TABLE>>];\n";
-    // Print Parent link
-    if (inner->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << inner->GetParentPageId() << ":p" << inner->GetPageId() << " -> " << internal_prefix
-          << inner->GetPageId() << ";\n";
-    }
     // Print leaves
     for (int i = 0; i < inner->GetSize(); i++) {
-      auto child_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i))->GetData());
+      ReadPageGuard child_guard = bpm->FetchPageRead(inner->ValueAt(i));
+      auto child_page = child_guard.As<BPlusTreePage>();
       ToGraph(child_page, bpm, out);
-      if (i > 0) {
-        auto sibling_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i - 1))->GetData());
-        if (!sibling_page->IsLeafPage() && !child_page->IsLeafPage()) {
-          out << "{rank=same " << internal_prefix << sibling_page->GetPageId() << " " << internal_prefix
-              << child_page->GetPageId() << "};\n";
-        }
-        bpm->UnpinPage(sibling_page->GetPageId(), false);
+      // Print the link from this page to the child
+      out << internal_prefix << inner->GetPageId() << ":p" << child_page->GetPageId() << " -> "
+          << (child_page->IsLeafPage() ? leaf_prefix : internal_prefix) << child_page->GetPageId() << ";\n";
+      if (i > 0 && !child_page->IsLeafPage()) {
+        out << "{rank=same " << internal_prefix << inner->ValueAt(i - 1) << " " << internal_prefix
+            << child_page->GetPageId() << "};\n";
       }
     }
   }
-  bpm->UnpinPage(page->GetPageId(), false);
 }
 
 /**
@@ -571,29 +990,28 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
  * @param bpm
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
+void BPLUSTREE_TYPE::ToString(const BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
-    auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page);
-    std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+    auto leaf = reinterpret_cast<const LeafPage *>(page);
+    std::cout << "Leaf Page: " << leaf->GetPageId() << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
   } else {
-    InternalPage *internal = reinterpret_cast<InternalPage *>(page);
-    std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
+    auto internal = reinterpret_cast<const InternalPage *>(page);
+    std::cout << "Internal Page: " << internal->GetPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
       std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
-      ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(internal->ValueAt(i))->GetData()), bpm);
+      ReadPageGuard child_guard = bpm->FetchPageRead(internal->ValueAt(i));
+      ToString(child_guard.As<BPlusTreePage>(), bpm);
     }
   }
-  bpm->UnpinPage(page->GetPageId(), false);
 }
 
 template class BPlusTree<GenericKey<4>, RID, GenericComparator<4>>;
@@ -2,48 +2,57 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "common/config.h"
+#include "common/exception.h"
 #include "common/logger.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
-// INDEX_TEMPLATE_ARGUMENTS
-// INDEXITERATOR_TYPE::IndexIterator() = default;
-
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
-  if (current_leaf_node_ != nullptr) {
-    buffer_pool_manager_->UnpinPage(current_leaf_node_->GetPageId(), false);
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index)
+    : buffer_pool_manager_(bpm), guard_(std::move(guard)), page_id_(guard_.PageId()), index_(index) {
+  if (guard_.IsValid()) {
+    // Start reading the next leaf while this one is being scanned.
+    buffer_pool_manager_->PrefetchPage(Leaf()->GetNextPageId());
+    SkipExhaustedLeaves();
   }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::isEnd() { return current_leaf_node_ == nullptr || index_ >= current_leaf_node_->GetSize(); }
+INDEXITERATOR_TYPE::~IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { return current_leaf_node_->GetItem(index_); }
+bool INDEXITERATOR_TYPE::isEnd() { return !guard_.IsValid(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() { return Leaf()->GetItem(index_); }
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   index_ += 1;
-  if (index_ >= current_leaf_node_->GetMaxSize()) {
-    const page_id_t next = current_leaf_node_->GetNextPageId();
-    if (next == INVALID_PAGE_ID) {
-      return *this;
-    } else {
-      Page *page = buffer_pool_manager_->FetchPage(next);
-      current_leaf_node_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
-      buffer_pool_manager_->UnpinPage(next, false);
-      index_ = 0;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (guard_.IsValid() && index_ >= Leaf()->GetSize()) {
+    const page_id_t next_page_id = Leaf()->GetNextPageId();
+    index_ = 0;
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+      break;
     }
+    guard_ = buffer_pool_manager_->FetchPageRead(next_page_id);
+    if (!guard_.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for B+ tree page");
+    }
+    buffer_pool_manager_->PrefetchPage(Leaf()->GetNextPageId());
   }
-  return *this;
+  page_id_ = guard_.PageId();
 }
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <sstream>
@@ -23,17 +24,45 @@ namespace bustub {
  *****************************************************************************/
 /*
  * Init method after creating a new internal page
- * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * Including set page type, set current size, set page id and set max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, int max_size) {
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
   SetPageId(page_id);
-  SetParentPageId(parent_id);
+  SetLevel(1);
+  SetNextPageId(INVALID_PAGE_ID);
   SetMaxSize(max_size);
 }
+
+/*
+ * Helper methods to get/set the right sibling on the same level
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+/*
+ * Helper methods to get/set the high key, which the last page of a level has
+ * none of
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &key) { high_key_ = key; }
+
+/*
+ * Helper method to check whether key belongs to the pages right of this one,
+ * so that a lookup has to move right
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsBeyondHighKey(const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) >= 0;
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
@@ -83,17 +112,45 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
   assert(GetSize() > 1);
+  return LookupIn(key, comparator, GetSize());
+}
+
+/*
+ * Lookup for an optimistic read, which may see the page while it changes:
+ * the size is read only once, and a size no page can have is refused instead
+ * of searching past the end of the page. What it finds means nothing until
+ * the read is validated.
+ * @return false if the page is torn
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupOptimistic(const KeyType &key, const KeyComparator &comparator,
+                                                      ValueType *value) const {
+  const int size = GetSize();
+  if (size < 2 || size > static_cast<int>(INTERNAL_PAGE_SIZE) + 1) {
+    return false;
+  }
+  *value = LookupIn(key, comparator, size);
+  return true;
+}
+
+/*
+ * Binary search over the first size entries of the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIn(const KeyType &key, const KeyComparator &comparator,
+                                                  int size) const {
+  // find the first key greater than the input key; the child left of it covers the input key
   int first = 1;
-  int last = GetSize() - 1;
-  while (first <= last) {
+  int last = size;
+  while (first < last) {
     const int mi = (first + last) / 2;
-    if (comparator(key, KeyAt(mi)) <= 0) {
-      last = mi + 1;
+    if (comparator(array_[mi].first, key) <= 0) {
+      first = mi + 1;
     } else {
-      first = mi - 1;
+      last = mi;
     }
   }
-  return ValueAt(first - 1);
+  return array_[first - 1].second;
 }
 
 /*****************************************************************************
@@ -131,35 +188,55 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
   return GetSize();
 }
 
+/*
+ * Insert new_key & new_value pair at the place of new_key among the keys. The
+ * child left of it may not be the page new_value was split from yet, if that
+ * page was split off another child and is not linked in either; the key range
+ * of that child then reaches up to new_key, and lookups move right from it.
+ * @return:  new size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &new_key, const ValueType &new_value,
+                                           const KeyComparator &comparator) {
+  int index = GetSize();
+  while (index > 1 && comparator(array_[index - 1].first, new_key) > 0) {
+    array_[index] = array_[index - 1];
+    --index;
+  }
+  array_[index] = MappingType(new_key, new_value);
+  IncreaseSize(1);
+  return GetSize();
+}
+
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to "recipient" page, a new
+ * page that becomes my right sibling. The first key moved, now the invalid key
+ * of the recipient, is the one to push up into the parent, and my new high
+ * key. The recipient takes over my sibling and my old high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                                BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient) {
   assert(recipient->GetSize() == 0);
   const int size = GetSize();
-  const int half = GetMinSize();
-  CopyNFrom(array_ + half, size - half, buffer_pool_manager);
-  IncreaseSize(-half);
+  const int half = size / 2;
+  recipient->CopyNFrom(array_ + half, size - half);
+  SetSize(half);
+  recipient->SetLevel(GetLevel());
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
 }
 
-/* Copy entries into me, starting from {items} and copy {size} entries.
- * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
- * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
+/* Copy entries into me, starting from {items} and append {size} entries.
+ * Children do not point back to their parent, so they need no update.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  for (int i = 0; i < size; ++i) {
-    array_[i] = items[i];
-    Page *page = buffer_pool_manager->FetchPage(array_[i].second);
-    auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    child->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child->GetPageId(), true);
-  }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
+  std::copy(items, items + size, array_ + GetSize());
   IncreaseSize(size);
 }
 
@@ -195,93 +272,69 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page.
- * The middle_key is the separation key you should get from the parent. You need
- * to make sure the middle key is added to the recipient to maintain the invariant.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
+ * Remove all of key & value pairs from this page to "recipient" page, my left sibling.
+ * The middle_key is the separation key you should get from the parent. It becomes
+ * the key of my first child in the recipient, which also takes over my sibling and my high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
   array_[0].first = middle_key;
-  recipient->CopyNFrom(array_, GetSize(), buffer_pool_manager);
+  recipient->CopyNFrom(array_, GetSize());
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
   SetSize(0);
-  buffer_pool_manager->UnpinPage(GetPageId(), true);
 }
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to tail of "recipient" page.
+ * Remove the first key & value pair from this page to tail of "recipient" page, my left sibling.
  *
- * The middle_key is the separation key you should get from the parent. You need
- * to make sure the middle key is added to the recipient to maintain the invariant.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
+ * The middle_key is the separation key you should get from the parent. It becomes the key
+ * of the moved child; my new invalid key, KeyAt(0), is the new separation key and the new
+ * high key of the recipient.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
   assert(GetSize() > 0);
-  MappingType pair = std::make_pair(middle_key, ValueAt(0));
-  recipient->CopyLastFrom(pair, buffer_pool_manager);
-
-  for (int i = 0; i < GetSize() - 1; ++i) {
-    array_[i] = array_[i + 1];
-  }
-
+  recipient->CopyLastFrom(std::make_pair(middle_key, ValueAt(0)));
+  std::copy(array_ + 1, array_ + GetSize(), array_);
   IncreaseSize(-1);
-  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
+  recipient->SetHighKey(array_[0].first);
 }
 
 /* Append an entry at the end.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair) {
   array_[GetSize()] = pair;
   IncreaseSize(1);
-  Page *page = buffer_pool_manager->FetchPage(ValueAt(GetSize() - 1));
-  auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  child->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child->GetPageId(), true);
 }
 
 /*
- * Remove the last key & value pair from this page to head of "recipient" page.
- * You need to handle the original dummy key properly, e.g. updating recipient’s array to position the middle_key at the
- * right place.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
- * moved to the recipient
+ * Remove the last key & value pair from this page to head of "recipient" page, my right sibling.
+ *
+ * The middle_key is the separation key you should get from the parent. It becomes the key
+ * of the recipient's old first child; the recipient's new invalid key, KeyAt(0), is the new
+ * separation key.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {
-  MappingType pair = std::make_pair(middle_key, ValueAt(GetSize() - 1));
-  recipient->CopyLastFrom(pair, buffer_pool_manager);
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
+  assert(GetSize() > 0);
+  recipient->SetKeyAt(0, middle_key);
+  recipient->CopyFirstFrom(array_[GetSize() - 1]);
   IncreaseSize(-1);
-  array_[0].first = middle_key;
-  buffer_pool_manager->UnpinPage(GetPageId(), true);
+  SetHighKey(recipient->array_[0].first);
 }
 
 /* Append an entry at the beginning.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
-  for (int i = GetSize(); i > 0; --i) {
-    array_[i] = array_[i - 1];
-  }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair) {
+  std::copy_backward(array_, array_ + GetSize(), array_ + GetSize() + 1);
   array_[0] = pair;
-  Page *page = buffer_pool_manager->FetchPage(ValueAt(0));
-  auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  child->SetParentPageId(GetPageId());
   IncreaseSize(1);
-  buffer_pool_manager->UnpinPage(child->GetPageId(), true);
 }
 
 // valuetype for internalNode should be page id_t
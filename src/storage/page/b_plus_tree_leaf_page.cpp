@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include <algorithm>
 #include <iterator>
 #include <sstream>
 #include "common/exception.h"
@@ -24,15 +25,16 @@ namespace bustub {
 
 /**
  * Init method after creating a new leaf page
- * Including set page type, set current size to zero, set page id/parent id, set
+ * Including set page type, set current size to zero, set page id, set
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, int max_size) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetPageId(page_id);
-  SetParentPageId(parent_id);
+  SetLevel(0);
+  SetNextPageId(INVALID_PAGE_ID);
   SetMaxSize(max_size);
 }
 
@@ -45,6 +47,24 @@ page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return next_page_i
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
+/**
+ * Helper methods to set/get the high key, which only the last leaf has none of
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &key) { high_key_ = key; }
+
+/**
+ * Helper method to check whether key belongs to the pages right of this one,
+ * so that a lookup has to move right
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsBeyondHighKey(const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) >= 0;
+}
+
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
@@ -71,7 +91,7 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  assert(0 <= index && index < GetMaxSize());
+  assert(0 <= index && index < GetSize());
   return array_[index].first;
 }
 
@@ -80,8 +100,8 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  assert(0 <= index && index < GetMaxSize());
+const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  assert(0 <= index && index < GetSize());
   return array_[index];
 }
 
@@ -101,7 +121,6 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
   }
   array_[index].first = key;
   array_[index].second = value;
-  LOG_DEBUG("Insert Index:%d, key: %lld, value: %lld", index, key.ToString(), value.Get());
   IncreaseSize(1);
   return GetSize();
 }
@@ -110,30 +129,31 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to "recipient" page, a new
+ * page that becomes my right sibling. It takes over my sibling and my high
+ * key, and its first key becomes my high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient, BufferPoolManager *) {
-  assert(GetSize() > 0);
-  assert(recipient != nullptr);
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  assert(recipient != nullptr && recipient->GetSize() == 0);
   const int size = GetSize();
-  const int half = GetMinSize();
+  const int half = size / 2;
   recipient->CopyNFrom(array_ + half, size - half);
-  SetSize(size - half);
+  SetSize(half);
   recipient->SetNextPageId(GetNextPageId());
-  SetNextPageId(recipient->GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
 }
 
 /*
- * Copy starting from items, and copy {size} number of elements into me.
+ * Copy starting from items, and append {size} number of elements to me.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
-  assert(items != nullptr && size > 0);
-  for (int i = 0; i < size; ++i) {
-    array_[i] = items[i];
-  }
-  SetSize(size);
+  assert(items != nullptr && size >= 0);
+  std::copy(items, items + size, array_ + GetSize());
+  IncreaseSize(size);
 }
 
 /*****************************************************************************
@@ -146,10 +166,8 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
-  // LOG_DEBUG("Lookup leaf page key: %d", key);
   const int index = KeyIndex(key, comparator);
-  LOG_DEBUG("Look up key, value at index: %d", index);
-  if (index < GetSize() && !comparator(key, KeyAt(index))) {
+  if (index < GetSize() && comparator(key, KeyAt(index)) == 0) {
     *value = array_[index].second;
     return true;
   }
@@ -168,7 +186,7 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
   const int index = KeyIndex(key, comparator);
-  if (index < GetSize() && !comparator(key, KeyAt(index))) {
+  if (index < GetSize() && comparator(key, KeyAt(index)) == 0) {
     for (int i = index + 1; i < GetSize(); ++i) {
       array_[i - 1] = array_[i];
     }
@@ -181,14 +199,14 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page. Don't forget
- * to update the next_page id in the sibling page
+ * Remove all of key & value pairs from this page to "recipient" page, my left
+ * sibling, which takes over my place in the leaf chain and my high key
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient, const KeyType &midddle_key,
-                                           BufferPoolManager *buffer_manager) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
   recipient->CopyNFrom(array_, GetSize());
   recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
   SetSize(0);
 }
 
@@ -196,18 +214,17 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient, const K
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to "recipient" page.
+ * Remove the first key & value pair from this page to "recipient" page, my left
+ * sibling, whose high key becomes my new first key. The caller updates the
+ * separator key in the parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient, const KeyType &midddle_key,
-                                                  BufferPoolManager *buffer_manager) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
   assert(GetSize() > 0);
-  recipient->CopyLastFrom(GetItem(0));
-  for (int i = 0; i < GetSize() - 1; ++i) {
-    array_[i] = array_[i + 1];
-  }
+  recipient->CopyLastFrom(array_[0]);
+  std::copy(array_ + 1, array_ + GetSize(), array_);
   IncreaseSize(-1);
-  buffer_manager->UnpinPage(GetParentPageId(), true);
+  recipient->SetHighKey(KeyAt(0));
 }
 
 /*
@@ -220,21 +237,16 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
 }
 
 /*
- * Remove the last key & value pair from this page to "recipient" page.
+ * Remove the last key & value pair from this page to "recipient" page, my right
+ * sibling. My high key becomes the moved key. The caller updates the separator
+ * key in the parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient, const KeyType &middle_key,
-                                                   BufferPoolManager *buffer_manager) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
   assert(GetSize() > 0);
   recipient->CopyFirstFrom(array_[GetSize() - 1]);
   IncreaseSize(-1);
-
-  Page *page = buffer_manager->FetchPage(GetParentPageId());
-  auto parent = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
-  array_[0].first = middle_key;
-  //      parent->SetKeyAt(0, recipient->GetKeyAt(0));
-
-  buffer_manager->UnpinPage(parent->GetPageId(), true);
+  SetHighKey(recipient->KeyAt(0));
 }
 
 /*
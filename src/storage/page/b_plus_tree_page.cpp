@@ -19,15 +19,14 @@ namespace bustub {
 // lsn_				4	Log sequence number (Used in Project 4)
 // size_			4	Number of Key & Value pairs in page
 // max_size_		4	Max number of Key & Value pairs in page
-// parent_page_id_	4	Parent Page Id
 // page_id_			4	Self Page Id
+// level_			4	Level of the page, 0 for leaves
 
 /*
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
  */
 bool BPlusTreePage::IsLeafPage() const { return page_type_ == IndexPageType::LEAF_PAGE; }
-bool BPlusTreePage::IsRootPage() const { return parent_page_id_ == INVALID_PAGE_ID; }
 void BPlusTreePage::SetPageType(IndexPageType page_type) { page_type_ = page_type; }
 
 /*
@@ -46,21 +45,11 @@ void BPlusTreePage::SetMaxSize(int size) { max_size_ = size; }
 
 /*
  * Helper method to get min page size
- * Generally, min page size == max page size / 2
+ * A full page splits into two halves of at least this size, and two pages
+ * below it always fit into one. The root is exempt: a leaf root may hold a
+ * single entry, an internal root two children.
  */
-int BPlusTreePage::GetMinSize() const {
-  if (IsRootPage()) {
-    // root & leaf page may be empty tree, so size is 1; otherwise size is 2
-    return IsLeafPage() ? 1 : 2;
-  }
-  return (max_size_ + 1) / 2;
-}
-
-/*
- * Helper methods to get/set parent page id
- */
-page_id_t BPlusTreePage::GetParentPageId() const { return parent_page_id_; }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) { parent_page_id_ = parent_page_id; }
+int BPlusTreePage::GetMinSize() const { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
 
 /*
  * Helper methods to get/set self page id
@@ -68,6 +57,13 @@ void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) { parent_page_id_
 page_id_t BPlusTreePage::GetPageId() const { return page_id_; }
 void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
+/*
+ * Helper methods to get/set the level of the page, 0 for leaf pages and one
+ * more than its children for an internal page
+ */
+int BPlusTreePage::GetLevel() const { return level_; }
+void BPlusTreePage::SetLevel(int level) { level_ = level; }
+
 /*
  * Helper methods to set lsn
  */
@@ -11,15 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(std::move(strategy)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, strategy_.get());
   }
 }
 
@@ -35,19 +37,22 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_.get()));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
+  PrefetchAhead(cur_page->GetTablePageId(), cur_page->GetNextPageId());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page =
+          static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), strategy_.get()));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      PrefetchAhead(cur_page->GetTablePageId(), cur_page->GetNextPageId());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -56,7 +61,7 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, strategy_.get());
   }
   // release until copy the tuple
   cur_page->RUnlatch();
@@ -70,4 +75,43 @@ TableIterator TableIterator::operator++(int) {
   return clone;
 }
 
+void TableIterator::PrefetchAhead(page_id_t page_id, page_id_t next_page_id) {
+  if (page_id == prefetch_next_ && prefetch_ahead_ > 1) {
+    // The scan moved on to the next page of the list, so the tail is one page closer. A prefetch that was dropped for
+    // want of a free frame is tried again on every page.
+    prefetch_ahead_--;
+    prefetch_issued_ = false;
+  } else if (page_id != prefetch_page_id_) {
+    prefetch_tail_ = next_page_id;
+    prefetch_ahead_ = 1;
+    prefetch_issued_ = false;
+  }
+  prefetch_page_id_ = page_id;
+  prefetch_next_ = next_page_id;
+
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  while (prefetch_tail_ != INVALID_PAGE_ID) {
+    auto tail_page = static_cast<TablePage *>(
+        prefetch_ahead_ < PREFETCH_DEPTH ? buffer_pool_manager->FetchResidentPage(prefetch_tail_) : nullptr);
+    if (tail_page == nullptr) {
+      if (!prefetch_issued_) {
+        buffer_pool_manager->PrefetchPage(prefetch_tail_, strategy_.get());
+        prefetch_issued_ = true;
+      }
+      return;
+    }
+    tail_page->RLatch();
+    const page_id_t tail_next_page_id = tail_page->GetNextPageId();
+    tail_page->RUnlatch();
+    buffer_pool_manager->UnpinPage(prefetch_tail_, false);
+    // The last page of the table; pages appended later are picked up on the next call.
+    if (tail_next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    prefetch_tail_ = tail_next_page_id;
+    prefetch_ahead_++;
+    prefetch_issued_ = false;
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// background_writer_test.cpp
+//
+// Identification: test/buffer/background_writer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, CleanColdFramesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages and keep the last two pinned.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  for (size_t i = 0; i < buffer_pool_size - 2; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+
+  // Scenario: the write budget is respected, and the coldest pages are written first.
+  EXPECT_EQ(2, bpm->CleanColdFrames(100, 2));
+  EXPECT_FALSE(bpm->GetFrame(0)->IsDirty());
+  EXPECT_FALSE(bpm->GetFrame(1)->IsDirty());
+  EXPECT_TRUE(bpm->GetFrame(2)->IsDirty());
+
+  // Scenario: keep half of the pool clean.
+  EXPECT_EQ(3, bpm->CleanColdFrames(50, 100));
+  EXPECT_EQ(0, bpm->CleanColdFrames(50, 100));
+  // The writes run in the background.
+  disk_manager->DrainAsyncIO();
+  EXPECT_EQ(5, disk_manager->GetNumWrites());
+
+  // Scenario: a page that is pinned again is not written, even though it was cold.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[5]));
+  EXPECT_EQ(2, bpm->CleanColdFrames(100, 100));
+  EXPECT_TRUE(bpm->GetFrame(5)->IsDirty());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[5], false));
+  disk_manager->DrainAsyncIO();
+
+  // Scenario: new pages evict the cleaned frames without writing anything.
+  for (int i = 0; i < 7; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(7, disk_manager->GetNumWrites());
+
+  // The cleaned pages were written with their contents.
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page " + std::to_string(page_ids[0]), std::string(page->GetData()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, BackgroundThreadTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const auto saved_interval = bgwriter_interval;
+  bgwriter_interval = std::chrono::milliseconds(5);
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, buffer_pool_size, disk_manager, nullptr, ReplacerType::CLOCK);
+  bpm->StartBackgroundWriter(25, 2);
+  bpm->StartBackgroundWriter();
+
+  // Scenario: dirty pages are created and released while the writer runs.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // The writer cleans 25% of every instance, i.e. two frames each, without being asked to.
+  for (int i = 0; i < 400 && disk_manager->GetNumWrites() < 4; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  bpm->StopBackgroundWriter();
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(4, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+  bgwriter_interval = saved_interval;
+}
+
+}  // namespace bustub
@@ -0,0 +1,197 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** @return true if page_id is resident in one of the frames of bpm */
+static bool IsResident(BufferPoolManager *bpm, page_id_t page_id) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); ++i) {
+    if (bpm->GetFrame(i)->GetPageId() == page_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_hot_pages = 6;
+  const int num_scan_pages = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_hot_pages + num_scan_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  const std::vector<page_id_t> hot(page_ids.begin(), page_ids.begin() + num_hot_pages);
+  const std::vector<page_id_t> scan(page_ids.begin() + num_hot_pages, page_ids.end());
+
+  // Scenario: the hot pages are resident.
+  for (auto page_id : hot) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a scan reads many more pages than the pool holds through a ring of four frames.
+  auto strategy = bpm->GetScanStrategy(4);
+  for (auto page_id : scan) {
+    auto *page = bpm->FetchPage(page_id, strategy.get());
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // The scan only recycled its own frames, so the hot pages are still resident.
+  for (auto page_id : hot) {
+    EXPECT_TRUE(IsResident(bpm, page_id));
+  }
+
+  // Scenario: without a strategy, the same scan flushes the hot pages out.
+  for (auto page_id : scan) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (auto page_id : hot) {
+    EXPECT_FALSE(IsResident(bpm, page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, SharedPageTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, 4, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the scan reads a page into its ring, and another query pins it while the scan moves on.
+  auto strategy = bpm->GetScanStrategy(1);
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+
+  // The pinned page is not recycled; the scan takes a frame from the replacer instead.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  EXPECT_TRUE(IsResident(bpm, page_ids[0]));
+
+  // From now on the scan recycles its own frame again.
+  for (size_t i = 2; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i], strategy.get()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_TRUE(IsResident(bpm, page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: another query fetches a page of the ring and is done with it before the scan moves on. The page has
+  // joined the shared working set and is left to the replacer.
+  strategy = bpm->GetScanStrategy(1);
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[2], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[2], false));
+  EXPECT_TRUE(IsResident(bpm, page_ids[1]));
+
+  // A page only the scan fetched, even more than once, is recycled.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[2], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[2], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[3], strategy.get()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[3], false));
+  EXPECT_FALSE(IsResident(bpm, page_ids[2]));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, TableHeapScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 100};
+  Schema schema{{col1, col2}};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, 64, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+
+  // Scenario: the table spans many more pages than the pool holds.
+  const int num_tuples = 5000;
+  for (int i = 0; i < num_tuples; ++i) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(80, 'x'))};
+    Tuple tuple(values, &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Scenario: an unrelated hot page is resident.
+  page_id_t hot_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&hot_page_id));
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+
+  // A full scan sees every tuple in order and leaves the hot page alone.
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    EXPECT_EQ(count, itr->GetValue(&schema, 0).GetAs<int32_t>());
+    ++count;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_TRUE(IsResident(bpm, hot_page_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+}  // namespace bustub
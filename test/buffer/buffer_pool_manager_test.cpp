@@ -11,9 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <atomic>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -263,4 +266,90 @@ TEST(BufferPoolManagerTest, SampleTest3) {
 
   remove("test.db");
 }
+
+TEST(BufferPoolManagerTest, OptimisticReadTest) {
+  const size_t buffer_pool_size = 3;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  bpm->UnpinPage(page_id, true);
+
+  // An unchanged page validates; a write in between does not, and a write in progress fails right away.
+  uint64_t version;
+  ASSERT_EQ(page, bpm->FetchPageOptimistic(page_id, &version));
+  EXPECT_TRUE(page->ValidateOptimisticRead(version));
+  page->WLatch();
+  EXPECT_EQ(nullptr, bpm->FetchPageOptimistic(page_id, &version));
+  page->WUnlatch();
+  EXPECT_FALSE(page->ValidateOptimisticRead(version));
+
+  // A resident page is pinned without the latch of the buffer pool.
+  ASSERT_EQ(page, bpm->FetchResidentPage(page_id));
+  EXPECT_EQ(1, page->GetPinCount());
+  bpm->UnpinPage(page_id, false);
+
+  // Readers neither block nor are blocked by a read latch.
+  page->RLatch();
+  ASSERT_EQ(page, bpm->FetchPageOptimistic(page_id, &version));
+  EXPECT_TRUE(page->ValidateOptimisticRead(version));
+  page->RUnlatch();
+
+  // Evicting the page invalidates reads of it, and its frame is not handed out for it any more.
+  ASSERT_EQ(page, bpm->FetchPageOptimistic(page_id, &version));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t other_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+    bpm->UnpinPage(other_page_id, false);
+  }
+  EXPECT_FALSE(page->ValidateOptimisticRead(version));
+  EXPECT_EQ(nullptr, bpm->FetchPageOptimistic(page_id, &version));
+  // Without a read from disk, an evicted page cannot be pinned either.
+  EXPECT_EQ(nullptr, bpm->FetchResidentPage(page_id));
+
+  // A writer keeps two counters equal under the latch; a validated read must never see them differ.
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  std::atomic<bool> done{false};
+  std::atomic<int> validated{0};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; ++tid) {
+    readers.emplace_back([&] {
+      while (!done) {
+        uint64_t snapshot;
+        Page *read_page = bpm->FetchPageOptimistic(page_id, &snapshot);
+        if (read_page == nullptr) {
+          continue;
+        }
+        uint64_t first;
+        uint64_t second;
+        memcpy(&first, read_page->GetData(), sizeof(first));
+        memcpy(&second, read_page->GetData() + PAGE_SIZE - sizeof(second), sizeof(second));
+        if (read_page->ValidateOptimisticRead(snapshot)) {
+          ASSERT_EQ(first, second);
+          validated++;
+        }
+      }
+    });
+  }
+  for (uint64_t i = 1; i <= 100000; ++i) {
+    page->WLatch();
+    memcpy(page->GetData(), &i, sizeof(i));
+    memcpy(page->GetData() + PAGE_SIZE - sizeof(i), &i, sizeof(i));
+    page->WUnlatch();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_GT(validated, 0);
+  bpm->UnpinPage(page_id, true);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
 }  // namespace bustub
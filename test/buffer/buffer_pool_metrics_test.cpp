@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics_test.cpp
+//
+// Identification: test/buffer/buffer_pool_metrics_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolMetricsTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, 4, disk_manager);
+
+  // Scenario: new pages are neither hits nor misses; once the pool is full, the next one is turned away.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  page_id_t temp_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&temp_page_id));
+  BufferPoolMetrics metrics = bpm->GetMetrics();
+  EXPECT_EQ(0, metrics.hits);
+  EXPECT_EQ(0, metrics.misses);
+  EXPECT_EQ(1, metrics.no_free_frame);
+
+  // Scenario: fetching resident pages counts hits.
+  for (page_id_t page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, page_id % 4 < 2));
+  }
+  metrics = bpm->GetMetrics();
+  EXPECT_EQ(4, metrics.hits);
+  EXPECT_EQ(1.0, metrics.HitRatio());
+
+  // Scenario: four more pages evict the first four, half of which are dirty; reading those back counts misses.
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  metrics = bpm->GetMetrics();
+  EXPECT_EQ(4, metrics.evictions);
+  EXPECT_EQ(2, metrics.dirty_evictions);
+  for (page_id_t page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  metrics = bpm->GetMetrics();
+  EXPECT_EQ(4, metrics.misses);
+  EXPECT_EQ(0.5, metrics.HitRatio());
+
+  // Scenario: flushing counts the pages written.
+  bpm->FlushAllPages();
+  EXPECT_EQ(4, bpm->GetMetrics().flushes);
+
+  // Scenario: the instances add up to the whole pool, apart from what only the pool sees.
+  BufferPoolMetrics sum;
+  for (const auto &instance_metrics : bpm->GetInstanceMetrics()) {
+    sum += instance_metrics;
+  }
+  metrics = bpm->GetMetrics();
+  EXPECT_EQ(metrics.hits, sum.hits);
+  EXPECT_EQ(metrics.misses, sum.misses);
+  EXPECT_EQ(metrics.evictions, sum.evictions);
+  EXPECT_EQ(metrics.no_free_frame, sum.no_free_frame + 1);
+
+  // Scenario: the report has a line for the pool and one for every instance.
+  std::istringstream report(bpm->GetMetricsReport());
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(report, line);) {
+    lines.push_back(line);
+  }
+  ASSERT_EQ(3, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("hits=4 misses=4 hit_ratio=0.5"));
+  EXPECT_NE(std::string::npos, lines[1].find("instance 0: pool_size=2"));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolMetricsTest, ConcurrentHitTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, 8, disk_manager);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // Scenario: hits counted on the lock-free path by many threads at once all add up.
+  const int num_threads = 4;
+  const int num_fetches = 10000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_fetches; ++i) {
+        ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * num_fetches, bpm->GetMetrics().hits);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolMetricsTest, MetricsReporterTest) {
+  remove("test.metrics");
+  const auto default_interval = metrics_report_interval;
+  metrics_report_interval = std::chrono::milliseconds(10);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  bpm->StartMetricsReporter("test.metrics");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  bpm->StopMetricsReporter();
+  std::ifstream in("test.metrics");
+  std::string line;
+  ASSERT_TRUE(std::getline(in, line));
+  EXPECT_EQ(0, line.find("time_ms="));
+  EXPECT_NE(std::string::npos, line.find("buffer pool: pool_size=10 hits=0"));
+
+  metrics_report_interval = default_interval;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.metrics");
+}
+
+}  // namespace bustub
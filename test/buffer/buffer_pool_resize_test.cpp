@@ -0,0 +1,225 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_resize_test.cpp
+//
+// Identification: test/buffer/buffer_pool_resize_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, GrowTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, 4, disk_manager);
+
+  // Scenario: fill the pool with pinned pages.
+  std::vector<Page *> pages;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    pages.push_back(page);
+    page_ids.push_back(page_id);
+  }
+  page_id_t temp_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&temp_page_id));
+
+  // Scenario: growing past several chunks adds free frames and leaves the pinned pages where they are.
+  EXPECT_TRUE(bpm->Resize(30));
+  EXPECT_EQ(30, bpm->GetPoolSize());
+  for (int i = 4; i < 30; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    pages.push_back(page);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&temp_page_id));
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), pages[i]->GetData());
+    EXPECT_EQ(pages[i], bpm->FetchPage(page_ids[i]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, ShrinkTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, 16, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 16; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: shrinking evicts the unpinned pages of the frames that go away; their changes reach the disk.
+  EXPECT_TRUE(bpm->Resize(4));
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: only four pages fit now.
+  std::vector<page_id_t> pinned;
+  for (page_id_t page_id : page_ids) {
+    if (bpm->FetchPage(page_id) != nullptr) {
+      pinned.push_back(page_id);
+    }
+  }
+  EXPECT_EQ(4, pinned.size());
+  for (page_id_t page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the frames come back when the pool grows again.
+  EXPECT_TRUE(bpm->Resize(16));
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+  }
+  page_id_t temp_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&temp_page_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, ShrinkPinnedTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, 8, disk_manager);
+  const auto default_timeout = resize_drain_timeout;
+  resize_drain_timeout = std::chrono::milliseconds(50);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Scenario: a page that stays pinned in a frame that would go away keeps the pool from shrinking.
+  EXPECT_FALSE(bpm->Resize(2));
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  page_id_t temp_page_id;
+  for (int i = 0; i < 7; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&temp_page_id));
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(temp_page_id - i, false));
+  }
+
+  // Scenario: once the page is unpinned during the shrink, the shrink goes through.
+  resize_drain_timeout = std::chrono::seconds(10);
+  std::thread unpinner([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[7], false));
+  });
+  EXPECT_TRUE(bpm->Resize(2));
+  unpinner.join();
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  resize_drain_timeout = default_timeout;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, ConcurrentResizeTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 64;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, num_pages, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: readers keep fetching pages while the pool grows and shrinks under them.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; ++tid) {
+    readers.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<size_t> pick(0, page_ids.size() - 1);
+      while (!done) {
+        const page_id_t page_id = page_ids[pick(rng)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (size_t new_size : {16, 128, 8, 64, 32, 200, 12}) {
+    EXPECT_TRUE(bpm->Resize(new_size));
+    EXPECT_EQ(new_size, bpm->GetPoolSize());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
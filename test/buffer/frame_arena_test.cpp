@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, SampleTest) {
+  FrameArena arena(4);
+  EXPECT_EQ(0, arena.Capacity());
+  arena.Reserve(3);
+  EXPECT_EQ(4, arena.Capacity());
+
+  // Scenario: frames hold page-aligned data, and their descriptors start on cache lines of their own.
+  std::vector<Page *> frames;
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    Page *frame = arena.GetFrame(frame_id);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(frame) % CACHE_LINE_SIZE);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(frame->GetData()) % PAGE_SIZE);
+    EXPECT_NE(reinterpret_cast<char *>(frame), frame->GetData());
+    snprintf(frame->GetData(), PAGE_SIZE, "frame %d", frame_id);
+    frames.push_back(frame);
+  }
+
+  // Scenario: growing adds chunks twice the size of the previous one and leaves the existing frames in place.
+  arena.Reserve(13);
+  EXPECT_EQ(28, arena.Capacity());
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    EXPECT_EQ(frames[frame_id], arena.GetFrame(frame_id));
+    EXPECT_EQ("frame " + std::to_string(frame_id), arena.GetFrame(frame_id)->GetData());
+  }
+  for (frame_id_t frame_id = 4; frame_id < 28; ++frame_id) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(frame_id)->GetData()) % PAGE_SIZE);
+    EXPECT_EQ(0, arena.GetFrame(frame_id)->GetData()[0]);
+  }
+
+  // Scenario: a released frame reads as zeros.
+  arena.Release(1);
+  EXPECT_EQ(0, arena.GetFrame(1)->GetData()[0]);
+  EXPECT_EQ("frame 2", std::string(arena.GetFrame(2)->GetData()));
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, HugePageTest) {
+  // One chunk of 1024 frames is 4 MB, which huge pages back: reserved ones if there are any, transparent ones if not.
+  const size_t frames_per_huge_page = HUGE_PAGE_SIZE / PAGE_SIZE;
+  FrameArena arena(2 * frames_per_huge_page);
+  arena.Reserve(1);
+  EXPECT_LE(arena.NumHugeTlbChunks(), 1);
+  Page *first = arena.GetFrame(0);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(first->GetData()) % HUGE_PAGE_SIZE);
+
+  // The data of a chunk is contiguous, and every frame can be written.
+  for (size_t frame_id = 0; frame_id < arena.Capacity(); ++frame_id) {
+    Page *frame = arena.GetFrame(static_cast<frame_id_t>(frame_id));
+    EXPECT_EQ(first->GetData() + frame_id * PAGE_SIZE, frame->GetData());
+    memset(frame->GetData(), static_cast<int>(frame_id), PAGE_SIZE);
+  }
+  EXPECT_EQ(static_cast<char>(frames_per_huge_page + 1), arena.GetFrame(frames_per_huge_page + 1)->GetData()[100]);
+  arena.Release(0);
+  EXPECT_EQ(static_cast<char>(1), arena.GetFrame(1)->GetData()[100]);
+}
+
+}  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Each of them has been accessed once.
+  lru_replacer.Unpin(1);
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  lru_replacer.Unpin(4);
+  lru_replacer.Unpin(5);
+  lru_replacer.Unpin(6);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: access frame 1 a second time. It is now the only frame with a finite backward 2-distance.
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frames with a single access are evicted first, in order of that access.
+  int value;
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames cannot be victims. Pinning 3 has no effect on the size, since it is not in the replacer.
+  lru_replacer.Pin(3);
+  lru_replacer.Pin(5);
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: 5 now has two accesses too. 6 still has a single access and goes first. Frame 1's second most recent
+  // access is older than frame 5's, so 1 goes before 5.
+  lru_replacer.Unpin(5);
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const int hot_frames = 4;
+  const int num_frames = 8;
+  LRUKReplacer lru_replacer(num_frames, 2);
+
+  // Scenario: the hot frames are accessed twice.
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < hot_frames; ++i) {
+      lru_replacer.Pin(i);
+      lru_replacer.Unpin(i);
+    }
+  }
+
+  // Scenario: a scan touches every other frame exactly once, after the hot frames were last used.
+  for (int i = hot_frames; i < num_frames; ++i) {
+    lru_replacer.Pin(i);
+    lru_replacer.Unpin(i);
+  }
+
+  // Plain LRU would evict the hot frames now. LRU-K evicts the scanned frames first.
+  for (int i = hot_frames; i < num_frames; ++i) {
+    int value;
+    EXPECT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_EQ(hot_frames, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, BufferPoolManagerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU_K);
+
+  // Scenario: two hot pages are fetched repeatedly.
+  page_id_t hot[2];
+  for (auto &page_id : hot) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hot %d", page_id);
+    bpm->UnpinPage(page_id, true);
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  // Scenario: a scan creates many more pages than there are frames.
+  for (int i = 0; i < 10; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  // The hot pages survived the scan and are still resident: fetching them does not touch the disk.
+  const int num_writes = disk_manager->GetNumWrites();
+  for (auto page_id : hot) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("hot " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(page->IsDirty());
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(num_writes, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
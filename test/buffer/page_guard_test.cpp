@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/buffer/page_guard_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+class PageGuardTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.fsm");
+    disk_manager_ = new DiskManager("test.db");
+    bpm_ = new BufferPoolManager(buffer_pool_size_, disk_manager_);
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    disk_manager_->ShutDown();
+    delete bpm_;
+    delete disk_manager_;
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+  }
+
+  const size_t buffer_pool_size_ = 5;
+  DiskManager *disk_manager_;
+  BufferPoolManager *bpm_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, SampleTest) {
+  page_id_t page_id;
+  Page *page = bpm_->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  {
+    BasicPageGuard guard(bpm_, page);
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(page->GetData(), guard.GetData());
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Moving hands the pin over; the moved-from guard is empty and releases nothing.
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_TRUE(moved.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Assigning to a guard releases the page it held before.
+    BasicPageGuard other = bpm_->FetchPageBasic(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    other = std::move(moved);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Dropping twice unpins once.
+  BasicPageGuard guard = bpm_->FetchPageBasic(page_id);
+  guard.Drop();
+  guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_EQ(INVALID_PAGE_ID, guard.PageId());
+}
+
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, DirtyTest) {
+  page_id_t page_id;
+  {
+    BasicPageGuard guard = bpm_->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  {
+    ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+    EXPECT_STREQ("Hello", guard.GetData());
+  }
+
+  // Evict the page by filling the pool; the change must have been written back.
+  for (size_t i = 0; i < buffer_pool_size_; ++i) {
+    page_id_t other_page_id;
+    BasicPageGuard guard = bpm_->NewPageGuarded(&other_page_id);
+    ASSERT_TRUE(guard.IsValid());
+  }
+  {
+    WritePageGuard guard = bpm_->FetchPageWrite(page_id);
+    EXPECT_STREQ("Hello", guard.GetData());
+  }
+
+  // With every frame pinned, guards come back empty.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size_; ++i) {
+    page_id_t other_page_id;
+    guards.push_back(bpm_->NewPageGuarded(&other_page_id));
+  }
+  EXPECT_FALSE(bpm_->FetchPageRead(page_id).IsValid());
+  guards.clear();
+  EXPECT_TRUE(bpm_->FetchPageRead(page_id).IsValid());
+  EXPECT_FALSE(bpm_->CheckAllPinned());
+}
+
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, LatchTest) {
+  page_id_t page_id;
+  {
+    BasicPageGuard guard = bpm_->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+  }
+
+  // Readers share the page.
+  ReadPageGuard reader1 = bpm_->FetchPageRead(page_id);
+  ReadPageGuard reader2 = bpm_->FetchPageRead(page_id);
+
+  // A writer waits for both of them.
+  std::atomic<bool> written{false};
+  std::thread writer([&] {
+    WritePageGuard guard = bpm_->FetchPageWrite(page_id);
+    guard.AsMut<int>()[0] = 42;
+    written = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(written);
+  reader1.Drop();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(written);
+  reader2.Drop();
+  writer.join();
+  EXPECT_TRUE(written);
+
+  // Upgrading keeps the pin and takes the latch.
+  BasicPageGuard basic = bpm_->FetchPageBasic(page_id);
+  ReadPageGuard reader = basic.UpgradeRead();
+  EXPECT_FALSE(basic.IsValid());  // NOLINT
+  EXPECT_EQ(42, reader.As<int>()[0]);
+  reader.Drop();
+  EXPECT_EQ(1, bpm_->FetchPage(page_id)->GetPinCount());
+  bpm_->UnpinPage(page_id, false);
+}
+
+}  // namespace bustub
@@ -0,0 +1,327 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: page ids are spread round-robin over the instances, so we can fill the whole pool.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: unpin everything and create a second generation of pages, evicting the first one.
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: the evicted pages come back from disk through the instance that owns them.
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: deleting a pinned page fails, deleting an unpinned one succeeds.
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_FALSE(bpm->DeletePage(page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const int num_threads = 8;
+  const int num_pages = 64;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, 32, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  // Every thread fetches every page, so frames are evicted and re-read under contention.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&bpm, &page_ids]() {
+      for (int round = 0; round < 10; ++round) {
+        for (auto page_id : page_ids) {
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          page->RLatch();
+          EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+          page->RUnlatch();
+          bpm->UnpinPage(page_id, false);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, 32, disk_manager);
+
+  // Scenario: pages 0..9 and 20..29 are dirty, spread over all instances; 10..19 are clean.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 30; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  for (int i = 10; i < 20; ++i) {
+    ASSERT_TRUE(bpm->FlushPage(page_ids[i]));
+  }
+  // Pinned pages are flushed too, and stay pinned.
+  Page *pinned_page = bpm->FetchPage(page_ids[5]);
+  ASSERT_NE(nullptr, pinned_page);
+
+  // Scenario: the twenty dirty pages go out in two writes, one per run of adjacent pages.
+  const int num_writes = disk_manager->GetNumWrites();
+  const int num_write_calls = disk_manager->GetNumWriteCalls();
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_writes + 20, disk_manager->GetNumWrites());
+  EXPECT_EQ(num_write_calls + 2, disk_manager->GetNumWriteCalls());
+  EXPECT_EQ(1, pinned_page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[5], false));
+
+  // Scenario: nothing is dirty any more, and the disk holds every page.
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_write_calls + 2, disk_manager->GetNumWriteCalls());
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAfterEvictionTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, 8, disk_manager);
+
+  // Scenario: many more dirty pages than frames, so most of them are written back by evictions in the background.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 256; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: once the flush returns, the disk holds every page, including those evicted just before.
+  bpm->FlushAllPages();
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+/**
+ * Read-mostly throughput benchmark: every thread fetches random pages from a hot set that fits in the pool and
+ * dirties one page in twenty. The same workload runs once against a single latch and once against one instance per
+ * thread, and prints the operations per second of each configuration. Disabled by default; run it with
+ * --gtest_also_run_disabled_tests.
+ */
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ReadMostlyBenchmark) {
+  const std::string db_name = "test.db";
+  const int num_threads = std::max(4U, std::thread::hardware_concurrency());
+  const int num_pages = 512;
+  const int ops_per_thread = 50000;
+
+  auto run = [&](size_t num_instances) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(num_instances, num_pages, disk_manager);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id;
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+      bpm->UnpinPage(page_id, false);
+      page_ids.push_back(page_id);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&bpm, &page_ids, tid]() {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<size_t> pick(0, page_ids.size() - 1);
+        for (int i = 0; i < ops_per_thread; ++i) {
+          const page_id_t page_id = page_ids[pick(rng)];
+          if (bpm->FetchPage(page_id) != nullptr) {
+            bpm->UnpinPage(page_id, i % 20 == 0);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+    return num_threads * ops_per_thread / elapsed.count();
+  };
+
+  const double single = run(1);
+  const double sharded = run(num_threads);
+  std::cout << "threads: " << num_threads << ", 1 instance: " << static_cast<int64_t>(single) << " ops/s, "
+            << num_threads << " instances: " << static_cast<int64_t>(sharded) << " ops/s" << std::endl;
+  EXPECT_GT(single, 0);
+  EXPECT_GT(sharded, 0);
+}
+
+// Disabled by default; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_HotSetBenchmark) {
+  const std::string db_name = "test.db";
+  const int max_threads = std::max(8U, 2 * std::thread::hardware_concurrency());
+  const int num_hot_pages = 16;
+  const int ops_per_thread = 100000;
+
+  // A single instance and a tiny hot set that is always resident: every fetch is a hit, and every thread hits the
+  // same few frames, so the hit path itself is all that is measured.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(1, 64, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_hot_pages; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+    page_ids.push_back(page_id);
+  }
+
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&bpm, &page_ids, tid]() {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<size_t> pick(0, page_ids.size() - 1);
+        for (int i = 0; i < ops_per_thread; ++i) {
+          const page_id_t page_id = page_ids[pick(rng)];
+          Page *page = bpm->FetchPage(page_id);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(page_id, page->GetPageId());
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "threads: " << num_threads << ", hot set hits: "
+              << static_cast<int64_t>(num_threads * ops_per_thread / elapsed.count()) << " ops/s" << std::endl;
+  }
+
+  // No pin was lost or leaked on the way.
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    bpm->UnpinPage(page_id, false);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
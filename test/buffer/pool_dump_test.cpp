@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pool_dump_test.cpp
+//
+// Identification: test/buffer/pool_dump_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** @return true if page_id is resident in bpm, found without reading it from disk */
+static bool IsResident(BufferPoolManager *bpm, page_id_t page_id) {
+  uint64_t version;
+  return bpm->FetchPageOptimistic(page_id, &version) != nullptr;
+}
+
+/** Creates num_pages pages that hold their own id, and returns their ids. */
+static std::vector<page_id_t> CreatePages(BufferPoolManager *bpm, int num_pages) {
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  bpm->FlushAllPages();
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(PoolDumpTest, SampleTest) {
+  remove("test.bpdump");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, 10, disk_manager);
+  const std::vector<page_id_t> page_ids = CreatePages(bpm, 30);
+
+  // Scenario: touch the pages 10..19, so that they are the resident ones; the last ones touched are the hottest.
+  for (int i = 10; i < 20; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  ASSERT_TRUE(bpm->DumpResidentPages("test.bpdump"));
+  delete bpm;
+
+  // Scenario: a restarted pool of the same size gets exactly those pages back.
+  bpm = new BufferPoolManager(2, 10, disk_manager);
+  EXPECT_EQ(10, bpm->WarmUp("test.bpdump", 3));
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_EQ(i >= 10 && i < 20, IsResident(bpm, page_ids[i])) << "page " << page_ids[i];
+  }
+  auto *page = bpm->FetchPage(page_ids[15]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page " + std::to_string(page_ids[15]), page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[15], false));
+  delete bpm;
+
+  // Scenario: a smaller pool only gets the hottest pages.
+  bpm = new BufferPoolManager(2, 4, disk_manager);
+  EXPECT_EQ(4, bpm->WarmUp("test.bpdump"));
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_EQ(i >= 16 && i < 20, IsResident(bpm, page_ids[i])) << "page " << page_ids[i];
+  }
+
+  // Scenario: asking for no threads still reads the pages, on a single thread.
+  delete bpm;
+  bpm = new BufferPoolManager(1, 1, disk_manager);
+  EXPECT_EQ(1, bpm->WarmUp("test.bpdump", 0));
+
+  // Scenario: pages deallocated since the dump are skipped.
+  delete bpm;
+  bpm = new BufferPoolManager(2, 10, disk_manager);
+  EXPECT_TRUE(bpm->DeletePage(page_ids[19]));
+  EXPECT_EQ(9, bpm->WarmUp("test.bpdump"));
+  EXPECT_FALSE(IsResident(bpm, page_ids[19]));
+
+  // Scenario: a page count that does not match the size of the dump is not trusted.
+  {
+    std::ofstream out("test.bpdump", std::ios::binary | std::ios::trunc);
+    const uint32_t header[2] = {0x42504431, 0x7fffffff};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(page_ids.data()), sizeof(page_id_t));
+  }
+  EXPECT_EQ(0, bpm->WarmUp("test.bpdump"));
+
+  // Scenario: without a usable dump, nothing is loaded.
+  EXPECT_EQ(0, bpm->WarmUp("missing.bpdump"));
+  std::ofstream("test.bpdump", std::ios::trunc) << "garbage";
+  EXPECT_EQ(0, bpm->WarmUp("test.bpdump"));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.bpdump");
+}
+
+// NOLINTNEXTLINE
+TEST(PoolDumpTest, PoolDumperTest) {
+  remove("test.bpdump");
+  const auto default_interval = pool_dump_interval;
+  pool_dump_interval = std::chrono::milliseconds(10);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  const std::vector<page_id_t> page_ids = CreatePages(bpm, 5);
+
+  // Scenario: the dumper writes the file on its own.
+  bpm->StartPoolDumper("test.bpdump");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(std::ifstream("test.bpdump").good());
+
+  // Scenario: stopping it writes a last dump, with the pages created since.
+  const std::vector<page_id_t> more_page_ids = CreatePages(bpm, 5);
+  bpm->StopPoolDumper();
+  delete bpm;
+  bpm = new BufferPoolManager(10, disk_manager);
+  EXPECT_EQ(10, bpm->WarmUp("test.bpdump"));
+  EXPECT_TRUE(IsResident(bpm, more_page_ids.back()));
+
+  pool_dump_interval = default_interval;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.bpdump");
+}
+
+// NOLINTNEXTLINE
+TEST(PoolDumpTest, BustubInstanceTest) {
+  remove("test.db");
+  remove("test.bpdump");
+  page_id_t page_id;
+  {
+    BustubInstance instance("test.db", true);
+    auto *page = instance.buffer_pool_manager_->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hello");
+    instance.buffer_pool_manager_->UnpinPage(page_id, true);
+    instance.buffer_pool_manager_->FlushAllPages();
+  }
+
+  // Scenario: a restart with warm-up finds the page resident before any work starts.
+  {
+    BustubInstance instance("test.db", true);
+    EXPECT_TRUE(IsResident(instance.buffer_pool_manager_, page_id));
+  }
+
+  // Scenario: without warm-up, the pool starts cold and the dump is left alone.
+  remove("test.bpdump");
+  {
+    BustubInstance instance("test.db");
+    EXPECT_FALSE(IsResident(instance.buffer_pool_manager_, page_id));
+  }
+  EXPECT_FALSE(std::ifstream("test.bpdump").good());
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.bpdump");
+}
+
+}  // namespace bustub
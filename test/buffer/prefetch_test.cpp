@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetch_test.cpp
+//
+// Identification: test/buffer/prefetch_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Creates num_pages pages holding "page <id>", and evicts them all by creating as many pages again. */
+static std::vector<page_id_t> CreateColdPages(BufferPoolManager *bpm, int num_pages) {
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 2 * num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    if (i < num_pages) {
+      page_ids.push_back(page_id);
+    }
+  }
+  bpm->FlushAllPages();
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const int buffer_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, buffer_pool_size, disk_manager);
+  auto page_ids = CreateColdPages(bpm, buffer_pool_size);
+
+  // Scenario: prefetched pages can be fetched right away; fetching waits for reads that are still in flight.
+  bpm->PrefetchRange(page_ids[0], page_ids.size());
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: prefetching resident pages, invalid pages and pages past the end of the file does nothing.
+  bpm->PrefetchPage(page_ids[0]);
+  bpm->PrefetchPage(INVALID_PAGE_ID);
+  bpm->PrefetchPage(disk_manager->GetNumPages());
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: deallocated pages are not prefetched.
+  EXPECT_TRUE(bpm->DeletePage(page_ids[1]));
+  bpm->PrefetchRange(page_ids[0], 2);
+  bpm->PrefetchPage(page_ids[1]);
+  EXPECT_EQ(nullptr, bpm->FetchResidentPage(page_ids[1]));
+
+  // Scenario: a prefetch does not pin the page, so the pool can still be filled with new pages.
+  for (int i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const int num_threads = 4;
+  const int num_pages = 64;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, num_pages / 2, disk_manager);
+  auto page_ids = CreateColdPages(bpm, num_pages);
+
+  // Every thread prefetches ahead of itself while others fetch, evict and prefetch the same pages.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&bpm, &page_ids]() {
+      for (int round = 0; round < 5; ++round) {
+        for (size_t i = 0; i < page_ids.size(); ++i) {
+          bpm->PrefetchRange(page_ids[i], 4);
+          auto *page = bpm->FetchPage(page_ids[i]);
+          if (page == nullptr) {
+            continue;
+          }
+          page->RLatch();
+          EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(page->GetData()));
+          page->RUnlatch();
+          bpm->UnpinPage(page_ids[i], false);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, StaleFrameTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager, nullptr, ReplacerType::LRU);
+
+  // Scenario: a page id handed out again while a frame still holds its old contents gets a single, fresh frame.
+  const page_id_t page_id = disk_manager->AllocatePage();
+  auto *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "old");
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ("", std::string(page->GetData()));
+  EXPECT_EQ(std::vector<page_id_t>{page_id}, bpm->GetResidentPages());
+
+  // Scenario: a pinned page id is not handed out a second frame.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, FailedReadTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(1, disk_manager, nullptr, ReplacerType::LRU);
+  const page_id_t page_id = disk_manager->AllocatePage();
+  const page_id_t other_page_id = disk_manager->AllocatePage();
+
+  // Scenario: a failed read leaves nothing behind; the page is read again when fetched and the frame can be reused.
+  ASSERT_NE(nullptr, bpm->BeginPrefetch(page_id));
+  bpm->CompletePrefetch(page_id, false);
+  EXPECT_EQ(nullptr, bpm->FetchResidentPage(page_id));
+  EXPECT_TRUE(bpm->GetResidentPages().empty());
+  ASSERT_NE(nullptr, bpm->NewPage(other_page_id));
+  EXPECT_TRUE(bpm->UnpinPage(other_page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * Cold-cache scan benchmark: reads every page of a file that does not fit in the pool once with plain fetches and
+ * once keeping PREFETCH_DEPTH pages in flight, and prints the pages per second of each. Disabled by default; run it
+ * with --gtest_also_run_disabled_tests.
+ */
+// NOLINTNEXTLINE
+TEST(PrefetchTest, DISABLED_ColdScanBenchmark) {
+  const std::string db_name = "test.db";
+  const int buffer_pool_size = 64;
+  const int num_pages = 4096;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto page_ids = CreateColdPages(bpm, num_pages);
+
+  auto scan = [&](bool prefetch) {
+    auto strategy = bpm->GetScanStrategy();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      if (prefetch && i % PREFETCH_DEPTH == 0) {
+        bpm->PrefetchRange(page_ids[i] + PREFETCH_DEPTH, PREFETCH_DEPTH, strategy.get());
+      }
+      auto *page = bpm->FetchPage(page_ids[i], strategy.get());
+      EXPECT_NE(nullptr, page);
+      bpm->UnpinPage(page_ids[i], false);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return page_ids.size() / elapsed.count();
+  };
+
+  const double plain = scan(false);
+  const double prefetched = scan(true);
+  std::cout << "pages: " << num_pages << ", fetch: " << static_cast<int64_t>(plain)
+            << " pages/s, prefetch: " << static_cast<int64_t>(prefetched) << " pages/s" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -10,19 +10,23 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstdio>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
 #include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(CatalogTest, DISABLED_CreateTableTest) {
+TEST(CatalogTest, CreateTableTest) {
   auto disk_manager = new DiskManager("catalog_test.db");
   auto bpm = new BufferPoolManager(32, disk_manager);
   auto catalog = new Catalog(bpm, nullptr, nullptr);
@@ -38,14 +42,123 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
 
   Schema schema(columns);
   auto *table_metadata = catalog->CreateTable(nullptr, table_name, schema);
-  (void)table_metadata;
-
-  // Notice that this test case doesn't check anything! :(
-  // It is up to you to extend it
+  ASSERT_NE(nullptr, table_metadata);
+  EXPECT_EQ(table_name, table_metadata->name_);
+  EXPECT_EQ(table_metadata, catalog->GetTable(table_name));
+  EXPECT_EQ(table_metadata, catalog->GetTable(table_metadata->oid_));
+  EXPECT_EQ(2, table_metadata->schema_.GetColumnCount());
+  EXPECT_TRUE(catalog->GetTableIndexes(table_name).empty());
 
   delete catalog;
   delete bpm;
+  disk_manager->ShutDown();
   delete disk_manager;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+}
+
+/** @return true if page_id is cached in one of the frames of bpm */
+static bool IsCached(BufferPoolManager *bpm, page_id_t page_id) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); ++i) {
+    if (bpm->GetFrame(i)->GetPageId() == page_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, BufferPoolTest) {
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  {
+    BustubInstance instance("catalog_test.db");
+    EXPECT_EQ(instance.buffer_pool_manager_, instance.GetBufferPool(BustubInstance::DEFAULT_BUFFER_POOL));
+    EXPECT_EQ(nullptr, instance.GetBufferPool("heap"));
+    BufferPoolManager *heap_pool = instance.CreateBufferPool("heap", 16);
+    BufferPoolManager *index_pool = instance.CreateBufferPool("index", 8);
+    EXPECT_EQ(heap_pool, instance.GetBufferPool("heap"));
+    EXPECT_EQ(index_pool, instance.GetBufferPool("index"));
+
+    page_id_t header_page_id;
+    ASSERT_NE(nullptr, instance.buffer_pool_manager_->NewPage(&header_page_id));
+    ASSERT_EQ(HEADER_PAGE_ID, header_page_id);
+    instance.buffer_pool_manager_->UnpinPage(header_page_id, true);
+
+    Transaction txn(0);
+    Catalog catalog(instance.buffer_pool_manager_, instance.lock_manager_, instance.log_manager_);
+    std::vector<Column> columns;
+    columns.emplace_back("A", TypeId::INTEGER);
+    columns.emplace_back("B", TypeId::INTEGER);
+    Schema schema(columns);
+    auto *table_metadata = catalog.CreateTable(&txn, "potato", schema, heap_pool);
+    ASSERT_NE(nullptr, table_metadata);
+    EXPECT_TRUE(IsCached(heap_pool, table_metadata->table_->GetFirstPageId()));
+    EXPECT_FALSE(IsCached(instance.buffer_pool_manager_, table_metadata->table_->GetFirstPageId()));
+
+    const int num_tuples = 500;
+    std::vector<RID> rids;
+    for (int i = 0; i < num_tuples; ++i) {
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 2)}, &schema);
+      RID rid;
+      ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rid, &txn));
+      rids.push_back(rid);
+    }
+
+    // The index is built from the rows already in the table, in its own pool; only the header page, where it
+    // records its root, goes through the default pool.
+    Schema key_schema(std::vector<Column>{columns[0]});
+    auto *index_info = catalog.CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_pk", "potato",
+                                                                                     schema, key_schema, {0}, 8,
+                                                                                     index_pool);
+    ASSERT_NE(nullptr, index_info);
+    EXPECT_EQ(index_info, catalog.GetIndex("potato_pk", "potato"));
+    EXPECT_EQ(index_info, catalog.GetIndex(index_info->index_oid_));
+    ASSERT_EQ(1, catalog.GetTableIndexes("potato").size());
+    EXPECT_THROW(catalog.GetIndex("tomato_pk", "potato"), std::out_of_range);
+    for (int i = 0; i < num_tuples; ++i) {
+      std::vector<RID> result;
+      Tuple key({ValueFactory::GetIntegerValue(i)}, &key_schema);
+      index_info->index_->ScanKey(key, &result, &txn);
+      ASSERT_EQ(1, result.size());
+      EXPECT_EQ(rids[i], result[0]);
+    }
+    EXPECT_TRUE(IsCached(instance.buffer_pool_manager_, HEADER_PAGE_ID));
+    EXPECT_FALSE(IsCached(index_pool, HEADER_PAGE_ID));
+    EXPECT_FALSE(IsCached(heap_pool, HEADER_PAGE_ID));
+  }
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  remove("catalog_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, BufferPoolWarmUpTest) {
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  page_id_t page_id;
+  {
+    // The same page ends up in the dumps of two pools, as it would if they were taken at different times.
+    BustubInstance instance("catalog_test.db", true);
+    BufferPoolManager *heap_pool = instance.CreateBufferPool("heap", 16);
+    ASSERT_NE(nullptr, instance.buffer_pool_manager_->NewPage(&page_id));
+    instance.buffer_pool_manager_->UnpinPage(page_id, true);
+    instance.buffer_pool_manager_->FlushAllPages();
+    ASSERT_NE(nullptr, heap_pool->FetchPage(page_id));
+    heap_pool->UnpinPage(page_id, false);
+  }
+  {
+    // Scenario: only the pool that warms up first gets the page.
+    BustubInstance instance("catalog_test.db", true);
+    BufferPoolManager *heap_pool = instance.CreateBufferPool("heap", 16);
+    EXPECT_TRUE(IsCached(instance.buffer_pool_manager_, page_id));
+    EXPECT_FALSE(IsCached(heap_pool, page_id));
+  }
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  remove("catalog_test.log");
+  remove("catalog_test.bpdump");
+  remove("catalog_test.heap.bpdump");
 }
 
 }  // namespace bustub
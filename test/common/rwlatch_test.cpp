@@ -10,6 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -57,4 +61,71 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, WriterStarvationTest) {
+  // Readers overlap so that the latch is never free of them; a writer must still get in.
+  ReaderWriterLatch latch;
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; ++tid) {
+    readers.emplace_back([&] {
+      while (!done) {
+        latch.RLock();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        latch.RUnlock();
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  for (int i = 0; i < 10; ++i) {
+    latch.WLock();
+    latch.WUnlock();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+// Disabled by default; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(RWLatchTest, DISABLED_ContentionBenchmark) {
+  const int max_threads = std::max(8U, 2 * std::thread::hardware_concurrency());
+  const int ops_per_thread = 200000;
+
+  // Every thread works on the same latch and counter, with short critical sections like those on tree nodes.
+  for (int write_percent : {0, 10, 50}) {
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      ReaderWriterLatch latch;
+      int64_t count = 0;
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.emplace_back([&latch, &count, write_percent]() {
+          int64_t sum = 0;
+          for (int i = 0; i < ops_per_thread; ++i) {
+            if (i % 100 < write_percent) {
+              latch.WLock();
+              ++count;
+              latch.WUnlock();
+            } else {
+              latch.RLock();
+              sum += count;
+              latch.RUnlock();
+            }
+          }
+          EXPECT_GE(sum, 0);
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "threads: " << num_threads << ", writes: " << write_percent << "%, latch ops: "
+                << static_cast<int64_t>(num_threads * ops_per_thread / elapsed.count()) << " ops/s" << std::endl;
+      EXPECT_EQ(count, static_cast<int64_t>(num_threads) * (ops_per_thread / 100) * write_percent);
+    }
+  }
+}
 }  // namespace bustub
@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_engine_test.cpp
+//
+// Identification: test/storage/async_io_engine_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <future>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/async_io_engine.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+class AsyncIOEngineTest : public ::testing::TestWithParam<IOEngineType> {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    fd_ = open("test.db", O_RDWR | O_CREAT, 0644);
+    ASSERT_GE(fd_, 0);
+    // queue depth 4, so that the batch test below has to wait for room in the ring
+    engine_ = AsyncIOEngine::Create(GetParam(), 4, 2);
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    engine_.reset();
+    close(fd_);
+    remove("test.db");
+  }
+
+  int fd_;
+  std::unique_ptr<AsyncIOEngine> engine_;
+};
+
+// NOLINTNEXTLINE
+TEST_P(AsyncIOEngineTest, ReadWriteTest) {
+  // AUTO never reports itself; the sandbox may not allow io_uring, in which case we test the fallback.
+  EXPECT_TRUE(engine_->GetType() == GetParam() || engine_->GetType() == IOEngineType::THREAD_POOL);
+
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  std::promise<int64_t> written;
+  engine_->Submit({IORequest::Type::WRITE, fd_, data, PAGE_SIZE, PAGE_SIZE,
+                   [&written](int64_t result) { written.set_value(result); }});
+  EXPECT_EQ(PAGE_SIZE, written.get_future().get());
+
+  std::promise<int64_t> read;
+  engine_->Submit(
+      {IORequest::Type::READ, fd_, buf, PAGE_SIZE, PAGE_SIZE, [&read](int64_t result) { read.set_value(result); }});
+  EXPECT_EQ(PAGE_SIZE, read.get_future().get());
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+}
+
+// NOLINTNEXTLINE
+TEST_P(AsyncIOEngineTest, BatchTest) {
+  const int num_pages = 64;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::atomic<int> num_done{0};
+  std::vector<IORequest> requests;
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(pages[i].data(), PAGE_SIZE, "page %d", i);
+    requests.push_back({IORequest::Type::WRITE, fd_, pages[i].data(), PAGE_SIZE, static_cast<int64_t>(i) * PAGE_SIZE,
+                        [&num_done](int64_t result) {
+                          EXPECT_EQ(PAGE_SIZE, result);
+                          ++num_done;
+                        }});
+  }
+  engine_->SubmitBatch(std::move(requests));
+  engine_->Drain();
+  EXPECT_EQ(num_pages, num_done);
+
+  // Read everything back, again in one batch.
+  std::vector<std::vector<char>> read(num_pages, std::vector<char>(PAGE_SIZE));
+  for (int i = 0; i < num_pages; ++i) {
+    requests.push_back({IORequest::Type::READ, fd_, read[i].data(), PAGE_SIZE, static_cast<int64_t>(i) * PAGE_SIZE,
+                        [&num_done](int64_t result) {
+                          EXPECT_EQ(PAGE_SIZE, result);
+                          ++num_done;
+                        }});
+  }
+  engine_->SubmitBatch(std::move(requests));
+  engine_->Drain();
+  EXPECT_EQ(2 * num_pages, num_done);
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ("page " + std::to_string(i), std::string(read[i].data()));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_P(AsyncIOEngineTest, ShortReadTest) {
+  char data[PAGE_SIZE] = {0};
+  ASSERT_EQ(100, pwrite(fd_, data, 100, 0));
+
+  // The file ends before the requested range does.
+  char buf[PAGE_SIZE];
+  std::promise<int64_t> read;
+  engine_->Submit({IORequest::Type::READ, fd_, buf, PAGE_SIZE, 0, [&read](int64_t result) { read.set_value(result); }});
+  EXPECT_EQ(100, read.get_future().get());
+
+  // Reading from a bad file descriptor reports the error.
+  std::promise<int64_t> failed;
+  engine_->Submit(
+      {IORequest::Type::READ, -1, buf, PAGE_SIZE, 0, [&failed](int64_t result) { failed.set_value(result); }});
+  EXPECT_EQ(-EBADF, failed.get_future().get());
+}
+
+// NOLINTNEXTLINE
+TEST_P(AsyncIOEngineTest, SubmitterExitTest) {
+  // Requests outlive the threads that submitted them, as writes of pages evicted by short-lived workers do. The queue
+  // is deep enough for all of them to go to the device right away, and every round appends to the file.
+  engine_ = AsyncIOEngine::Create(GetParam(), 64, 2);
+  const int num_threads = 8;
+  const int num_pages = 64;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::atomic<int> num_written{0};
+  for (int round = 0; round < 16; ++round) {
+    const int64_t first_page = static_cast<int64_t>(round) * num_pages;
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < num_threads; ++t) {
+      submitters.emplace_back([&, t] {
+        for (int i = t; i < num_pages; i += num_threads) {
+          snprintf(pages[i].data(), PAGE_SIZE, "page %d round %d", i, round);
+          engine_->Submit({IORequest::Type::WRITE, fd_, pages[i].data(), PAGE_SIZE, (first_page + i) * PAGE_SIZE,
+                           [&num_written](int64_t result) {
+                             EXPECT_EQ(PAGE_SIZE, result);
+                             ++num_written;
+                           }});
+        }
+      });
+    }
+    for (auto &submitter : submitters) {
+      submitter.join();
+    }
+    engine_->Drain();
+    EXPECT_EQ((round + 1) * num_pages, num_written);
+
+    char buf[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      ASSERT_EQ(PAGE_SIZE, pread(fd_, buf, PAGE_SIZE, (first_page + i) * PAGE_SIZE));
+      EXPECT_STREQ(pages[i].data(), buf);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AsyncIOEngineTest, AsyncIOEngineTest,
+                         ::testing::Values(IOEngineType::IO_URING, IOEngineType::THREAD_POOL));
+
+// NOLINTNEXTLINE
+TEST(AsyncDiskManagerTest, ReadWritePageTest) {
+  remove("test.db");
+  remove("test.log");
+  for (auto type : {IOEngineType::AUTO, IOEngineType::THREAD_POOL}) {
+    DiskManager dm("test.db", false, SyncPolicy::NONE, type);
+    char buf[PAGE_SIZE] = {0};
+    char data[PAGE_SIZE] = {0};
+    char zeros[PAGE_SIZE] = {0};
+    std::strncpy(data, "A test string.", sizeof(data));
+
+    // Pages past the end of the file read back as zeros, right away.
+    std::memset(buf, 1, PAGE_SIZE);
+    std::promise<bool> zeroed;
+    dm.ReadPageAsync(7, buf, [&zeroed](bool ok) { zeroed.set_value(ok); });
+    EXPECT_TRUE(zeroed.get_future().get());
+    EXPECT_EQ(0, std::memcmp(buf, zeros, PAGE_SIZE));
+
+    std::promise<bool> written;
+    dm.WritePageAsync(5, data, [&written](bool ok) { written.set_value(ok); });
+    EXPECT_TRUE(written.get_future().get());
+    EXPECT_EQ(6, dm.GetNumPages());
+    EXPECT_EQ(1, dm.GetNumWrites());
+
+    std::promise<bool> read;
+    dm.ReadPageAsync(5, buf, [&read](bool ok) { read.set_value(ok); });
+    EXPECT_TRUE(read.get_future().get());
+    EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+
+    // A batch may mix pages on disk with pages past the end of the file.
+    char batch_buf[2][PAGE_SIZE];
+    std::memset(batch_buf, 1, sizeof(batch_buf));
+    std::promise<bool> batch_read[2];
+    std::vector<DiskManager::IOCallback> callbacks;
+    callbacks.emplace_back([&batch_read](bool ok) { batch_read[0].set_value(ok); });
+    callbacks.emplace_back([&batch_read](bool ok) { batch_read[1].set_value(ok); });
+    dm.ReadPagesAsync({5, 9}, {batch_buf[0], batch_buf[1]}, std::move(callbacks));
+    EXPECT_TRUE(batch_read[0].get_future().get());
+    EXPECT_TRUE(batch_read[1].get_future().get());
+    EXPECT_EQ(0, std::memcmp(batch_buf[0], data, PAGE_SIZE));
+    EXPECT_EQ(0, std::memcmp(batch_buf[1], zeros, PAGE_SIZE));
+
+    // The log goes through the engine too.
+    char log[] = "log record";
+    dm.WriteLog(log, sizeof(log));
+    char log_buf[sizeof(log)];
+    ASSERT_TRUE(dm.ReadLog(log_buf, sizeof(log), 0));
+    EXPECT_STREQ(log, log_buf);
+
+    dm.ShutDown();
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+}  // namespace bustub
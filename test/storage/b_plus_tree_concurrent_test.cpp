@@ -3,15 +3,18 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <iostream>
 #include <random>
 #include <thread>                   // NOLINT
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 // helper function to launch multiple threads
@@ -771,4 +774,339 @@ TEST(BPlusTreeConcurrentTest, MixTest3) {
   remove("test.db");
   remove("test.log");
 }
+
+// helper function to check that no page below the root is less than half full, once no thread changes the tree
+void CheckNoUnderflow(BufferPoolManager *bpm, page_id_t page_id, bool is_root) {
+  Page *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  const auto *node = reinterpret_cast<const BPlusTreePage *>(page->GetData());
+  if (!is_root) {
+    EXPECT_GE(node->GetSize(), node->GetMinSize()) << "page " << page_id;
+  }
+  if (!node->IsLeafPage()) {
+    const auto *internal =
+        reinterpret_cast<const BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(node);
+    for (int i = 0; i < internal->GetSize(); ++i) {
+      CheckNoUnderflow(bpm, internal->ValueAt(i), false);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+/*
+ * Removes and inserts release the latches above a page as soon as that page is safe. With tiny pages, leaves and
+ * internal pages split, merge and borrow all the time while other threads come down past them. Readers must find
+ * the keys nobody removes throughout, and whatever the interleaving, the tree has to end up with exactly the keys
+ * that were inserted and not removed.
+ */
+TEST(BPlusTreeConcurrentTest, RemoveWhileInsertingTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  const int num_threads = 4;
+  const int64_t num_keys = 1000;
+  // Runs of keys go, so that whole leaves empty and merges reach up the tree.
+  std::vector<int64_t> keys, removed_keys, kept_keys, inserted_keys;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    keys.push_back(key);
+    (key / 8 % 2 == 0 ? removed_keys : kept_keys).push_back(key);
+    inserted_keys.push_back(num_keys + key);
+  }
+  std::vector<int64_t> expected_keys = kept_keys;
+  expected_keys.insert(expected_keys.end(), inserted_keys.begin(), inserted_keys.end());
+
+  for (int round = 0; round < 10; ++round) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    InsertHelper(&tree, keys);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < num_threads; ++i) {
+      readers.emplace_back([&tree, &kept_keys, &done, i] {
+        GenericKey<8> index_key;
+        while (!done) {
+          for (size_t k = i; k < kept_keys.size() && !done; k += num_threads) {
+            std::vector<RID> rids;
+            index_key.SetFromInteger(kept_keys[k]);
+            ASSERT_TRUE(tree.GetValue(index_key, &rids)) << "key " << kept_keys[k];
+          }
+        }
+      });
+    }
+    std::vector<std::thread> writers;
+    for (int i = 0; i < num_threads; ++i) {
+      writers.emplace_back(DeleteHelperSplit, &tree, removed_keys, num_threads, i);
+      writers.emplace_back(InsertHelperSplit, &tree, inserted_keys, num_threads, i);
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+    done = true;
+    for (auto &reader : readers) {
+      reader.join();
+    }
+
+    size_t i = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it, ++i) {
+      ASSERT_LT(i, expected_keys.size());
+      ASSERT_EQ(expected_keys[i], (*it).second.GetSlotNum());
+    }
+    EXPECT_EQ(expected_keys.size(), i);
+    GenericKey<8> index_key;
+    for (auto key : removed_keys) {
+      std::vector<RID> rids;
+      index_key.SetFromInteger(key);
+      EXPECT_FALSE(tree.GetValue(index_key, &rids));
+    }
+    for (auto key : expected_keys) {
+      std::vector<RID> rids;
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.GetValue(index_key, &rids));
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+    page_id_t root_page_id;
+    ASSERT_TRUE(reinterpret_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID))->GetRootId("foo_pk", &root_page_id));
+    bpm->UnpinPage(HEADER_PAGE_ID, false);
+    CheckNoUnderflow(bpm, root_page_id, true);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+  delete key_schema;
+  remove("test.log");
+}
+
+/*
+ * A split of the root links the new page into a new root only after the split page is released. Other inserts can
+ * split pages of the same level in between, and must wait for that root rather than look for a parent above it.
+ * Tiny pages and many small trees make the root split over and over while every thread is inserting.
+ */
+TEST(BPlusTreeConcurrentTest, RootSplitTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  const int num_threads = 8;
+  const int64_t num_keys = 400;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    keys.push_back(key);
+  }
+  for (int round = 0; round < 50; ++round) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+
+    LaunchParallelTest(num_threads, InsertHelperSplit, &tree, keys, num_threads);
+
+    int64_t current_key = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+      ASSERT_EQ(current_key, (*it).second.GetSlotNum());
+      current_key += 1;
+    }
+    ASSERT_EQ(num_keys, current_key);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+  delete key_schema;
+  remove("test.log");
+}
+
+/*
+ * Splits link the new page into the parent after the split page is released. Lookups that come down in between have
+ * to move right to find the upper half, and must never miss a key that was in the tree all along.
+ */
+TEST(BPlusTreeConcurrentTest, SplitWhileReadingTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // small pages, so that every few inserts split a page somewhere
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  const int64_t num_keys = 2000;
+  std::vector<int64_t> even_keys;
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    (key % 2 == 0 ? even_keys : odd_keys).push_back(key);
+  }
+  InsertHelper(&tree, even_keys);
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; ++tid) {
+    readers.emplace_back([&] {
+      GenericKey<8> index_key;
+      while (!done) {
+        for (auto key : even_keys) {
+          std::vector<RID> rids;
+          index_key.SetFromInteger(key);
+          ASSERT_TRUE(tree.GetValue(index_key, &rids));
+          ASSERT_EQ(key, rids[0].GetSlotNum());
+        }
+      }
+    });
+  }
+  LaunchParallelTest(4, InsertHelperSplit, &tree, odd_keys, 4);
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  int64_t current_key = 0;
+  for (auto it = tree.begin(); it != tree.end(); ++it) {
+    EXPECT_EQ(current_key, (*it).second.GetSlotNum());
+    current_key += 1;
+  }
+  EXPECT_EQ(num_keys, current_key);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertBatchTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // Each thread inserts the keys of its own residue in one batch, so that the batches keep splitting each other's
+  // leaves.
+  const int64_t num_keys = 4000;
+  const int num_threads = 4;
+  std::atomic<size_t> inserted{0};
+  LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+    std::vector<std::pair<GenericKey<8>, RID>> entries;
+    GenericKey<8> index_key;
+    for (int64_t key = static_cast<int64_t>(thread_itr); key < num_keys; key += num_threads) {
+      index_key.SetFromInteger(key);
+      entries.emplace_back(index_key, RID(0, key));
+    }
+    inserted += tree.InsertBatch(&entries);
+  });
+  EXPECT_EQ(num_keys, inserted);
+
+  std::vector<GenericKey<8>> keys(num_keys);
+  for (int64_t key = 0; key < num_keys; ++key) {
+    keys[key].SetFromInteger(key);
+  }
+  std::vector<RID> rids;
+  std::vector<bool> found;
+  EXPECT_EQ(num_keys, tree.GetValues(keys, &rids, &found));
+  for (int64_t key = 0; key < num_keys; ++key) {
+    EXPECT_EQ(key, rids[key].GetSlotNum());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Throughput benchmark: threads look up random keys of a populated tree, and a share of them insert and remove keys
+ * of their own, so that leaves split and merge under the readers. Disabled by default; run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(BPlusTreeConcurrentTest, DISABLED_ThroughputBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  const int64_t num_keys = 20000;
+  const int ops_per_thread = 10000;
+
+  for (int write_percent : {0, 10, 50}) {
+    for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+      page_id_t page_id;
+      bpm->NewPage(&page_id);
+
+      // The tree holds the even keys; writers insert and remove odd ones.
+      std::vector<int64_t> keys;
+      for (int64_t key = 0; key < num_keys; ++key) {
+        keys.push_back(2 * key);
+      }
+      InsertHelper(&tree, keys);
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.emplace_back([&tree, tid, num_threads, write_percent, num_keys, ops_per_thread]() {
+          std::mt19937 rng(tid);
+          std::uniform_int_distribution<int64_t> pick(0, num_keys - 1);
+          GenericKey<8> index_key;
+          RID rid;
+          std::vector<RID> rids;
+          std::vector<int64_t> inserted;
+          for (int i = 0; i < ops_per_thread; ++i) {
+            if (i % 100 < write_percent) {
+              if (inserted.empty() || i % 2 == 0) {
+                // Odd keys of the form k * num_threads + tid belong to this thread alone.
+                const int64_t key = 2 * (pick(rng) / num_threads * num_threads + tid) + 1;
+                rid.Set(0, static_cast<uint32_t>(key));
+                index_key.SetFromInteger(key);
+                if (tree.Insert(index_key, rid)) {
+                  inserted.push_back(key);
+                }
+              } else {
+                index_key.SetFromInteger(inserted.back());
+                tree.Remove(index_key);
+                inserted.pop_back();
+              }
+            } else {
+              const int64_t key = 2 * pick(rng);
+              rids.clear();
+              index_key.SetFromInteger(key);
+              ASSERT_TRUE(tree.GetValue(index_key, &rids));
+              ASSERT_EQ(key, rids[0].GetSlotNum());
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "threads: " << num_threads << ", writes: " << write_percent << "%, tree ops: "
+                << static_cast<int64_t>(num_threads * ops_per_thread / elapsed.count()) << " ops/s" << std::endl;
+
+      int64_t size = 0;
+      for (auto it = tree.begin(); it != tree.end(); ++it) {
+        size += (*it).first.ToString() % 2 == 0 ? 1 : 0;
+      }
+      EXPECT_EQ(num_keys, size);
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete bpm;
+      delete disk_manager;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+  delete key_schema;
+}
 }  // namespace bustub
@@ -368,7 +368,7 @@ TEST(BPlusTreeDeleteTests, DeleteRandom) {
     EXPECT_EQ(location.GetSlotNum(), current_key);
     ++current_key;
   }
-  EXPECT_EQ(current_key, keys.size() + start_key);
+  EXPECT_EQ(current_key, scale);
 
   for (auto key : keys) {
     index_key.SetFromInteger(key);
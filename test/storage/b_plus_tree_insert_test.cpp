@@ -3,7 +3,11 @@
  */
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
 
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
@@ -48,8 +52,8 @@ TEST(BPlusTreeTests, InsertTest1) {
     EXPECT_EQ(rids.size(), 1);
 
     int64_t value = key & 0xFFFFFFFF;
-    LOG_DEBUG("rids size: %zu Get value: %lld slotNum:%u, value:%lld", rids.size(), rids[0].Get(), rids[0].GetSlotNum(),
-              value);
+    LOG_DEBUG("rids size: %zu Get value: %" PRId64 " slotNum:%u, value:%" PRId64, rids.size(), rids[0].Get(),
+              rids[0].GetSlotNum(), value);
     EXPECT_EQ(rids[0].GetSlotNum(), value);
   }
   int64_t start_key = 1;
@@ -141,4 +145,120 @@ TEST(BPlusTreeTests, InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  GenericKey<8> index_key;
+  RID rid;
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Shuffled, with a duplicate of every tenth key, whose first pair must win.
+  const int64_t num_keys = 1000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    index_key.SetFromInteger(2 * key);
+    entries.emplace_back(index_key, RID(0, 2 * key));
+    if (key % 10 == 0) {
+      entries.emplace_back(index_key, RID(1, 2 * key));
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  std::stable_partition(entries.begin(), entries.end(),
+                        [](const auto &entry) { return entry.second.GetPageId() == 0; });
+  EXPECT_TRUE(tree.BulkLoad(entries.begin(), entries.end(), 0.75));
+  EXPECT_FALSE(tree.BulkLoad(entries.begin(), entries.end()));
+
+  int64_t current_key = 0;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ(0, (*iterator).second.GetPageId());
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key += 2;
+  }
+  EXPECT_EQ(2 * num_keys, current_key);
+
+  // The loaded tree takes inserts and removes like any other.
+  for (int64_t key = 1; key < 2 * num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    EXPECT_TRUE(tree.Insert(index_key, rid));
+  }
+  for (int64_t key = 0; key < 2 * num_keys; key += 4) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  for (int64_t key = 0; key < 2 * num_keys; ++key) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 4 != 0, tree.GetValue(index_key, &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BatchTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Every third key, shuffled and twice over; the second copies are duplicates.
+  const int64_t num_keys = 3000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int round = 0; round < 2; ++round) {
+    for (int64_t key = 0; key < num_keys; key += 3) {
+      index_key.SetFromInteger(key);
+      entries.emplace_back(index_key, RID(round, key));
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  EXPECT_EQ(num_keys / 3, tree.InsertBatch(&entries));
+  index_key.SetFromInteger(num_keys + 3);
+  entries.assign(1, std::make_pair(index_key, RID(0, num_keys + 3)));
+  EXPECT_EQ(1, tree.InsertBatch(&entries));
+
+  std::vector<GenericKey<8>> keys;
+  for (int64_t key = num_keys + 3; key >= 0; --key) {
+    index_key.SetFromInteger(key);
+    keys.push_back(index_key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+  std::vector<RID> rids;
+  std::vector<bool> found;
+  EXPECT_EQ(num_keys / 3 + 1, tree.GetValues(keys, &rids, &found));
+  ASSERT_EQ(keys.size(), rids.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const int64_t key = keys[i].ToString();
+    EXPECT_EQ((key % 3 == 0 && key < num_keys) || key == num_keys + 3, found[i]);
+    if (found[i]) {
+      EXPECT_EQ(key, rids[i].GetSlotNum());
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
@@ -10,7 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdlib>
 #include <cstring>
+#include <future>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,12 +31,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   };
 };
 
@@ -72,6 +81,224 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FileSizeTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(0, dm.GetNumPages());
+    dm.WritePage(3, data);
+    EXPECT_EQ(4, dm.GetNumPages());
+    dm.WritePage(1, data);
+    EXPECT_EQ(4, dm.GetNumPages());
+    EXPECT_EQ(2, dm.GetNumWrites());
+    dm.ShutDown();
+  }
+
+  // The size of an existing file is picked up when it is opened again.
+  DiskManager dm(db_file);
+  EXPECT_EQ(4, dm.GetNumPages());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  // Falls back to buffered I/O if the file system does not support O_DIRECT; the results must be the same.
+  DiskManager dm(db_file, true, SyncPolicy::ALWAYS);
+  std::strncpy(data + 1, "An unaligned test string.", sizeof(data) - 1);
+
+  dm.WritePage(0, data);
+  dm.WritePage(2, data);
+  dm.ReadPage(2, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(1, buf);  // a hole in the file reads as zeros
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  std::string db_file("test.db");
+  for (bool direct_io : {false, true}) {
+    DiskManager dm(db_file, direct_io, SyncPolicy::ALWAYS);
+    // Page-aligned buffers, as the frames of the buffer pool are; the last one is not and takes the slow path.
+    std::vector<char *> buffers;
+    for (int i = 0; i < 3; ++i) {
+      buffers.push_back(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)));
+      std::memset(buffers[i], 'a' + i, PAGE_SIZE);
+    }
+
+    // Scenario: three adjacent pages go out in one system call and grow the file.
+    dm.WritePages(4, {buffers[0], buffers[1], buffers[2]});
+    dm.Sync();
+    EXPECT_EQ(7, dm.GetNumPages());
+    EXPECT_EQ(3, dm.GetNumWrites());
+    EXPECT_EQ(1, dm.GetNumWriteCalls());
+    char buf[PAGE_SIZE];
+    for (int i = 0; i < 3; ++i) {
+      dm.ReadPage(4 + i, buf);
+      EXPECT_EQ(0, std::memcmp(buf, buffers[i], PAGE_SIZE));
+    }
+
+    // Scenario: an unaligned page under O_DIRECT is written page by page, with the same result.
+    char unaligned[PAGE_SIZE + 1];
+    std::memset(unaligned + 1, 'z', PAGE_SIZE);
+    dm.WritePages(1, {buffers[0], unaligned + 1});
+    dm.ReadPage(2, buf);
+    EXPECT_EQ(0, std::memcmp(buf, unaligned + 1, PAGE_SIZE));
+    EXPECT_EQ(direct_io && dm.IsDirectIO() ? 3 : 2, dm.GetNumWriteCalls());
+
+    for (char *buffer : buffers) {
+      free(buffer);  // NOLINT
+    }
+    dm.ShutDown();
+    remove("test.db");
+    remove("test.fsm");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  DiskManager dm(db_file);
+
+  // Every thread writes and reads back its own pages, interleaved with the other threads.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&dm, tid]() {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          const page_id_t page_id = i * num_threads + tid;
+          std::memset(data, 0, sizeof(data));
+          snprintf(data, sizeof(data), "page %d round %d", page_id, round);
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm.GetNumWrites());
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumPages());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageReuseTest) {
+  DiskManager dm("test.db");
+  for (page_id_t page_id = 0; page_id < 200; ++page_id) {
+    EXPECT_EQ(page_id, dm.AllocatePage());
+  }
+
+  // Freed pages are reused lowest first, before the file grows.
+  dm.DeallocatePage(150);
+  dm.DeallocatePage(3);
+  dm.DeallocatePage(70);
+  dm.DeallocatePage(70);  // freeing a page twice is harmless
+  EXPECT_EQ(3, dm.GetFreeSpaceMap().GetNumFreePages());
+  EXPECT_FALSE(dm.GetFreeSpaceMap().IsAllocated(70));
+  EXPECT_EQ(3, dm.AllocatePage());
+  EXPECT_EQ(70, dm.AllocatePage());
+  EXPECT_EQ(150, dm.AllocatePage());
+  EXPECT_EQ(200, dm.AllocatePage());
+  EXPECT_EQ(0, dm.GetFreeSpaceMap().GetNumFreePages());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DeallocatePendingWriteTest) {
+  DiskManager dm("test.db");
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    EXPECT_EQ(page_id, dm.AllocatePage());
+  }
+
+  // Scenario: a page is deallocated while a write-back of it, started by any buffer pool, is still in flight. The page
+  // must not be handed out again before the write is done, or the write would overwrite its next contents.
+  char data[PAGE_SIZE] = {0};
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  dm.WritePageAsync(2, data, [released](bool) { released.wait(); });
+  std::atomic<bool> deallocated{false};
+  std::thread deallocator([&] {
+    dm.DeallocatePage(2);
+    deallocated = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(deallocated);
+  EXPECT_TRUE(dm.GetFreeSpaceMap().IsAllocated(2));
+
+  release.set_value();
+  deallocator.join();
+  EXPECT_TRUE(deallocated);
+  EXPECT_EQ(2, dm.AllocatePage());
+
+  // Writes of other pages do not hold up a deallocation.
+  std::promise<void> release_other;
+  std::shared_future<void> released_other = release_other.get_future().share();
+  dm.WritePageAsync(1, data, [released_other](bool) { released_other.wait(); });
+  dm.DeallocatePage(3);
+  EXPECT_FALSE(dm.GetFreeSpaceMap().IsAllocated(3));
+  release_other.set_value();
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, RecoverAllocationTest) {
+  char data[PAGE_SIZE] = {0};
+  {
+    DiskManager dm("test.db");
+    // More pages than one page of the map covers.
+    for (page_id_t page_id = 0; page_id < FreeSpaceMap::BITS_PER_PAGE + 10; ++page_id) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    dm.WritePage(0, data);
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(FreeSpaceMap::BITS_PER_PAGE + 2);
+    dm.ShutDown();
+  }
+
+  // The allocations survive a restart, including pages that were allocated but never written.
+  {
+    DiskManager dm("test.db");
+    EXPECT_TRUE(dm.GetFreeSpaceMap().IsAllocated(0));
+    EXPECT_FALSE(dm.GetFreeSpaceMap().IsAllocated(5));
+    EXPECT_EQ(FreeSpaceMap::BITS_PER_PAGE + 10, dm.GetFreeSpaceMap().GetNextPageId());
+    EXPECT_EQ(5, dm.AllocatePage());
+    EXPECT_EQ(FreeSpaceMap::BITS_PER_PAGE + 2, dm.AllocatePage());
+    EXPECT_EQ(FreeSpaceMap::BITS_PER_PAGE + 10, dm.AllocatePage());
+    dm.ShutDown();
+  }
+
+  // A database file without a map: every page it holds is taken to be in use.
+  remove("test.fsm");
+  {
+    DiskManager dm("test.db");
+    dm.WritePage(3, data);
+    dm.ShutDown();
+  }
+  remove("test.fsm");
+  DiskManager dm("test.db");
+  EXPECT_EQ(4, dm.AllocatePage());
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator_test.cpp
+//
+// Identification: test/storage/extent_allocator_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/extent_allocator.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class ExtentAllocatorTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.fsm");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(ExtentAllocatorTest, SampleTest) {
+  DiskManager disk_manager("test.db");
+  const size_t extent_size = 8;
+  {
+    ExtentAllocator a(&disk_manager, extent_size);
+    ExtentAllocator b(&disk_manager, extent_size);
+
+    // Interleaved allocations still give each allocator contiguous pages.
+    std::vector<page_id_t> a_pages;
+    std::vector<page_id_t> b_pages;
+    for (size_t i = 0; i < extent_size + 2; ++i) {
+      a_pages.push_back(a.AllocatePage());
+      b_pages.push_back(b.AllocatePage());
+    }
+    for (size_t i = 1; i < extent_size; ++i) {
+      EXPECT_EQ(a_pages[i - 1] + 1, a_pages[i]);
+      EXPECT_EQ(b_pages[i - 1] + 1, b_pages[i]);
+    }
+    EXPECT_EQ(0, a_pages[0]);
+    EXPECT_EQ(8, b_pages[0]);
+    EXPECT_EQ(16, a_pages[extent_size]);
+    EXPECT_EQ(24, b_pages[extent_size]);
+
+    // The page handed out last goes back into the extent.
+    EXPECT_EQ(18, a.AllocatePage());
+    a.DeallocatePage(18);
+    EXPECT_EQ(18, a.AllocatePage());
+
+    // Single pages fill holes; extents only go into holes large enough for them.
+    disk_manager.DeallocatePage(3);
+    EXPECT_EQ(3, disk_manager.AllocatePage());
+    disk_manager.DeallocateExtent(8, 4);
+    EXPECT_EQ(32, disk_manager.AllocateExtent(extent_size));
+    disk_manager.DeallocateExtent(12, 4);
+    EXPECT_EQ(8, disk_manager.AllocateExtent(extent_size));
+  }
+
+  // The unused rest of every extent was given back.
+  const FreeSpaceMap &map = disk_manager.GetFreeSpaceMap();
+  EXPECT_FALSE(map.IsAllocated(19));
+  EXPECT_TRUE(map.IsAllocated(18));
+  EXPECT_FALSE(map.IsAllocated(26));
+  EXPECT_TRUE(map.IsAllocated(25));
+  EXPECT_EQ(40, map.GetNextPageId());
+  EXPECT_EQ(5 + 6, map.GetNumFreePages());
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExtentAllocatorTest, ShutDownTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  ExtentAllocator allocator(disk_manager, 8);
+  EXPECT_EQ(0, allocator.AllocatePage());
+  EXPECT_EQ(1, allocator.AllocatePage());
+
+  // Shutting down gives back the rest of the extent; the allocator may outlive the disk manager.
+  disk_manager->ShutDown();
+  EXPECT_EQ(6, disk_manager->GetFreeSpaceMap().GetNumFreePages());
+  EXPECT_EQ(INVALID_PAGE_ID, allocator.AllocatePage());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExtentAllocatorTest, TableHeapTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, 64, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *transaction = new Transaction(0);
+
+  // Two tables grow at the same time.
+  auto *table_a = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  auto *table_b = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  std::vector<Column> columns{Column("a", TypeId::VARCHAR, 500)};
+  Schema schema(columns);
+  Tuple tuple({ValueFactory::GetVarcharValue(std::string(400, 'x'))}, &schema);
+  RID rid;
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_TRUE(table_a->InsertTuple(tuple, &rid, transaction));
+    ASSERT_TRUE(table_b->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Each table's page list runs through the file in order, without pages of the other table in between.
+  for (auto *table : {table_a, table_b}) {
+    int num_pages = 1;
+    page_id_t page_id = table->GetFirstPageId();
+    while (true) {
+      auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+      const page_id_t next_page_id = page->GetNextPageId();
+      bpm->UnpinPage(page_id, false);
+      if (next_page_id == INVALID_PAGE_ID) {
+        break;
+      }
+      EXPECT_EQ(page_id + 1, next_page_id);
+      page_id = next_page_id;
+      ++num_pages;
+    }
+    EXPECT_GT(num_pages, 1);
+  }
+
+  delete table_a;
+  delete table_b;
+  delete transaction;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
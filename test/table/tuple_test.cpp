@@ -21,6 +21,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +72,60 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, ScanPrefetchTest) {
+  Column col{"a", TypeId::VARCHAR, 1000};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{std::vector<Value>{ValueFactory::GetVarcharValue(std::string(1000, 'x'))}, &schema};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(2, 50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Two tables grow side by side, so each runs through several extents with extents of the other in between.
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto *other_table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  for (int i = 0; i < 4 * EXTENT_SIZE * 3; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    ASSERT_TRUE(other_table->InsertTuple(tuple, &rid, transaction));
+  }
+  std::vector<page_id_t> other_page_ids;
+  for (auto itr = other_table->Begin(transaction); itr != other_table->End(); ++itr) {
+    if (other_page_ids.empty() || other_page_ids.back() != itr->GetRid().GetPageId()) {
+      other_page_ids.push_back(itr->GetRid().GetPageId());
+    }
+  }
+  const page_id_t first_page_id = table->GetFirstPageId();
+  buffer_pool_manager->FlushAllPages();
+  delete other_table;
+  delete table;
+  delete buffer_pool_manager;
+
+  // Scenario: a scan over a cold pool reads ahead only along its own table's pages.
+  buffer_pool_manager = new BufferPoolManager(2, 50, disk_manager);
+  table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  size_t num_tuples = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    num_tuples++;
+  }
+  EXPECT_EQ(4 * EXTENT_SIZE * 3, num_tuples);
+  disk_manager->DrainAsyncIO();
+  for (auto page_id : other_page_ids) {
+    EXPECT_EQ(nullptr, buffer_pool_manager->FetchResidentPage(page_id)) << page_id;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");  // remove db file
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub